@@ -0,0 +1,381 @@
+#include "spacetyper/alloctracker.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  const int kScopeCount = static_cast<int>(AllocationScope::Count);
+
+  const char* const kScopeNames[kScopeCount] = {
+      "Other",
+      "Enemies",
+      "BulletList",
+      "SpriteFader",
+      "Background",
+      "Text",
+      "Gui"};
+}
+
+const char*
+AllocationScopeName(AllocationScope scope)
+{
+  const int index = static_cast<int>(scope);
+  if(index < 0 || index >= kScopeCount)
+  {
+    return "Unknown";
+  }
+  return kScopeNames[index];
+}
+
+#ifdef SPACETYPER_TRACK_ALLOCATIONS
+
+namespace
+{
+  // stored in front of every allocation so delete knows what to subtract,
+  // padded to keep the returned memory aligned
+  struct AllocationHeader
+  {
+    std::size_t size;
+    int         scope;
+  };
+  const std::size_t kHeaderSize = 16;
+  static_assert(sizeof(AllocationHeader) <= kHeaderSize, "header too big");
+
+  struct Counters
+  {
+    std::atomic<std::size_t> allocations;
+    std::atomic<std::size_t> frees;
+    std::atomic<std::size_t> bytes;
+    std::atomic<std::size_t> live;
+    std::atomic<std::size_t> peak;
+  };
+
+  // zero initialized before any static constructor runs
+  Counters g_frame[kScopeCount];
+  Counters g_total[kScopeCount];
+
+  std::atomic<std::size_t> g_live;
+  std::atomic<std::size_t> g_peak;
+  std::atomic<std::size_t> g_frame_peak;
+
+  std::size_t g_frame_index = 0;
+  std::FILE*  g_report      = nullptr;
+  bool        g_report_all  = false;
+
+  thread_local AllocationScope t_scope = AllocationScope::Other;
+
+  void
+  UpdatePeak(std::atomic<std::size_t>* peak, std::size_t value)
+  {
+    std::size_t current = peak->load(std::memory_order_relaxed);
+    while(value > current &&
+          !peak->compare_exchange_weak(
+              current, value, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  void
+  OnAlloc(Counters* c, std::size_t size)
+  {
+    c->allocations.fetch_add(1, std::memory_order_relaxed);
+    c->bytes.fetch_add(size, std::memory_order_relaxed);
+    const std::size_t live =
+        c->live.fetch_add(size, std::memory_order_relaxed) + size;
+    UpdatePeak(&c->peak, live);
+  }
+
+  void
+  OnFree(Counters* c, std::size_t size)
+  {
+    c->frees.fetch_add(1, std::memory_order_relaxed);
+    c->live.fetch_sub(size, std::memory_order_relaxed);
+  }
+
+  void*
+  TrackedAlloc(std::size_t size)
+  {
+    void* block = std::malloc(size + kHeaderSize);
+    if(block == nullptr)
+    {
+      return nullptr;
+    }
+
+    const int         scope  = static_cast<int>(t_scope);
+    AllocationHeader* header = static_cast<AllocationHeader*>(block);
+    header->size             = size;
+    header->scope            = scope;
+
+    OnAlloc(&g_frame[scope], size);
+    OnAlloc(&g_total[scope], size);
+    const std::size_t live =
+        g_live.fetch_add(size, std::memory_order_relaxed) + size;
+    UpdatePeak(&g_peak, live);
+    UpdatePeak(&g_frame_peak, live);
+
+    return static_cast<char*>(block) + kHeaderSize;
+  }
+
+  void
+  TrackedFree(void* ptr)
+  {
+    if(ptr == nullptr)
+    {
+      return;
+    }
+    void* block = static_cast<char*>(ptr) - kHeaderSize;
+    const AllocationHeader* header = static_cast<AllocationHeader*>(block);
+
+    OnFree(&g_frame[header->scope], header->size);
+    OnFree(&g_total[header->scope], header->size);
+    g_live.fetch_sub(header->size, std::memory_order_relaxed);
+
+    std::free(block);
+  }
+
+  std::size_t
+  Take(std::atomic<std::size_t>* value)
+  {
+    return value->exchange(0, std::memory_order_relaxed);
+  }
+}
+
+ScopedAllocationTag::ScopedAllocationTag(AllocationScope scope)
+    : previous_(t_scope)
+{
+  t_scope = scope;
+}
+
+ScopedAllocationTag::~ScopedAllocationTag()
+{
+  t_scope = previous_;
+}
+
+bool
+SetupAllocationReport(const std::string& path)
+{
+  if(path.empty())
+  {
+    g_report     = stderr;
+    g_report_all = false;
+    return true;
+  }
+
+  g_report     = std::fopen(path.c_str(), "w");
+  g_report_all = true;
+  if(g_report == nullptr)
+  {
+    std::fprintf(stderr, "Failed to open allocation report %s\n", path.c_str());
+    g_report = stderr;
+    return false;
+  }
+  std::fprintf(g_report, "frame scope allocations frees bytes live peak\n");
+  return true;
+}
+
+void
+EndAllocationFrame()
+{
+  // read the counters before writing anything, stdio might allocate
+  std::size_t allocations[kScopeCount];
+  std::size_t frees[kScopeCount];
+  std::size_t bytes[kScopeCount];
+  std::size_t live[kScopeCount];
+  std::size_t total_allocations = 0;
+  for(int i = 0; i < kScopeCount; ++i)
+  {
+    allocations[i] = Take(&g_frame[i].allocations);
+    frees[i]       = Take(&g_frame[i].frees);
+    bytes[i]       = Take(&g_frame[i].bytes);
+    live[i]        = g_total[i].live.load(std::memory_order_relaxed);
+    total_allocations += allocations[i];
+  }
+  const std::size_t frame_peak = g_frame_peak.exchange(
+      g_live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  const std::size_t frame = g_frame_index++;
+
+  if(g_report == nullptr)
+  {
+    return;
+  }
+
+  if(g_report_all)
+  {
+    for(int i = 0; i < kScopeCount; ++i)
+    {
+      std::fprintf(
+          g_report,
+          "%zu %s %zu %zu %zu %zu %zu\n",
+          frame,
+          kScopeNames[i],
+          allocations[i],
+          frees[i],
+          bytes[i],
+          live[i],
+          frame_peak);
+    }
+  }
+  else if(total_allocations > 0)
+  {
+    std::fprintf(
+        g_report, "frame %zu: %zu allocations,", frame, total_allocations);
+    for(int i = 0; i < kScopeCount; ++i)
+    {
+      if(allocations[i] > 0)
+      {
+        std::fprintf(
+            g_report,
+            " %s %zu (%zu bytes)",
+            kScopeNames[i],
+            allocations[i],
+            bytes[i]);
+      }
+    }
+    std::fprintf(g_report, ", peak live %zu bytes\n", frame_peak);
+  }
+}
+
+void
+PrintAllocationSummary()
+{
+  std::FILE* out = g_report != nullptr ? g_report : stderr;
+  std::fprintf(
+      out,
+      "allocations over %zu frames, peak live %zu bytes:\n",
+      g_frame_index,
+      g_peak.load(std::memory_order_relaxed));
+  for(int i = 0; i < kScopeCount; ++i)
+  {
+    const Counters& c = g_total[i];
+    std::fprintf(
+        out,
+        "  %-12s %zu allocations, %zu frees, %zu bytes, %zu live, %zu peak\n",
+        kScopeNames[i],
+        c.allocations.load(std::memory_order_relaxed),
+        c.frees.load(std::memory_order_relaxed),
+        c.bytes.load(std::memory_order_relaxed),
+        c.live.load(std::memory_order_relaxed),
+        c.peak.load(std::memory_order_relaxed));
+  }
+  std::fflush(out);
+}
+
+bool
+GetHeapUsage(std::size_t* live, std::size_t* peak)
+{
+  *live = g_live.load(std::memory_order_relaxed);
+  *peak = g_peak.load(std::memory_order_relaxed);
+  return true;
+}
+
+void*
+operator new(std::size_t size)
+{
+  void* ptr = TrackedAlloc(size);
+  if(ptr == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void*
+operator new[](std::size_t size)
+{
+  void* ptr = TrackedAlloc(size);
+  if(ptr == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return TrackedAlloc(size);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return TrackedAlloc(size);
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  TrackedFree(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+  TrackedFree(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+  TrackedFree(ptr);
+}
+
+void
+operator delete[](void* ptr, std::size_t) noexcept
+{
+  TrackedFree(ptr);
+}
+
+void
+operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+  TrackedFree(ptr);
+}
+
+void
+operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+  TrackedFree(ptr);
+}
+
+#else
+
+ScopedAllocationTag::ScopedAllocationTag(AllocationScope)
+    : previous_(AllocationScope::Other)
+{
+}
+
+ScopedAllocationTag::~ScopedAllocationTag()
+{
+}
+
+bool
+SetupAllocationReport(const std::string&)
+{
+  std::fprintf(
+      stderr, "Allocation tracking needs SPACETYPER_TRACK_ALLOCATIONS\n");
+  return false;
+}
+
+void
+EndAllocationFrame()
+{
+}
+
+void
+PrintAllocationSummary()
+{
+}
+
+bool
+GetHeapUsage(std::size_t* live, std::size_t* peak)
+{
+  *live = 0;
+  *peak = 0;
+  return false;
+}
+
+#endif
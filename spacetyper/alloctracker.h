@@ -0,0 +1,52 @@
+#ifndef SPACETYPER_ALLOCTRACKER_H
+#define SPACETYPER_ALLOCTRACKER_H
+
+#include <cstddef>
+#include <string>
+
+// Opt-in allocation tracking, build with SPACETYPER_TRACK_ALLOCATIONS to
+// hook the global operator new/delete. Without it everything here is a no-op.
+
+enum class AllocationScope
+{
+  Other,
+  Enemies,
+  BulletList,
+  SpriteFader,
+  Background,
+  Text,
+  Gui,
+  Count
+};
+
+const char*
+AllocationScopeName(AllocationScope scope);
+
+// tags all allocations on this thread until it goes out of scope
+class ScopedAllocationTag
+{
+ public:
+  explicit ScopedAllocationTag(AllocationScope scope);
+  ~ScopedAllocationTag();
+
+ private:
+  AllocationScope previous_;
+};
+
+// where to write the per-frame report, empty means stderr and only the
+// frames that allocated anything are printed
+bool
+SetupAllocationReport(const std::string& path);
+
+void
+EndAllocationFrame();
+
+void
+PrintAllocationSummary();
+
+// bytes allocated right now and at most, safe to call from any thread.
+// false without tracking
+bool
+GetHeapUsage(std::size_t* live, std::size_t* peak);
+
+#endif  // SPACETYPER_ALLOCTRACKER_H
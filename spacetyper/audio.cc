@@ -0,0 +1,298 @@
+#include "spacetyper/audio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "core/assert.h"
+
+#include "spacetyper/trig.h"
+
+namespace
+{
+  // deterministic so the effects sound the same every time
+  class Noise
+  {
+   public:
+    Noise()
+        : state_(22222)
+    {
+    }
+
+    float
+    Next()
+    {
+      state_ = state_ * 1664525u + 1013904223u;
+      return static_cast<float>(state_ >> 8) / (1 << 23) - 1.0f;
+    }
+
+   private:
+    uint32_t state_;
+  };
+
+  std::vector<float>
+  Shot(int frequency)
+  {
+    // a short downward sweep
+    const int          length = frequency / 8;
+    std::vector<float> samples(length);
+    float              phase = 0.0f;
+    for(int i = 0; i < length; ++i)
+    {
+      const float t = static_cast<float>(i) / length;
+      phase += (1400.0f - 1100.0f * t) / frequency;
+      const float square = std::fmod(phase, 1.0f) < 0.5f ? 1.0f : -1.0f;
+      samples[i]         = square * 0.25f * (1.0f - t) * (1.0f - t);
+    }
+    return samples;
+  }
+
+  std::vector<float>
+  Hit(int frequency)
+  {
+    // a click of noise over a low thump
+    const int          length = frequency / 10;
+    std::vector<float> samples(length);
+    Noise              noise;
+    for(int i = 0; i < length; ++i)
+    {
+      const float t     = static_cast<float>(i) / length;
+      const float thump = std::sin(2.0f * kPi * 120.0f * i / frequency);
+      samples[i] =
+          (noise.Next() * std::exp(-t * 30.0f) + thump * (1.0f - t)) * 0.3f;
+    }
+    return samples;
+  }
+
+  std::vector<float>
+  Explosion(int frequency)
+  {
+    // low passed noise with a slow decay
+    const int          length = frequency * 3 / 4;
+    std::vector<float> samples(length);
+    Noise              noise;
+    float              low = 0.0f;
+    for(int i = 0; i < length; ++i)
+    {
+      const float t = static_cast<float>(i) / length;
+      low += (noise.Next() - low) * (0.2f - 0.15f * t);
+      samples[i] = low * 1.5f * std::exp(-t * 4.0f);
+    }
+    return samples;
+  }
+}
+
+SoundBuffer
+SynthesizeSound(Sound sound, int frequency)
+{
+  ASSERT(sound != Sound::Count);
+  SoundBuffer buffer;
+  switch(sound)
+  {
+    case Sound::Shot:
+      buffer.samples = Shot(frequency);
+      break;
+    case Sound::Hit:
+      buffer.samples = Hit(frequency);
+      break;
+    case Sound::Explosion:
+      buffer.samples = Explosion(frequency);
+      break;
+    case Sound::Count:
+      break;
+  }
+  return buffer;
+}
+
+bool
+LoadWav(
+    const std::string& path,
+    int                frequency,
+    SoundBuffer*       buffer,
+    std::string*       error)
+{
+  SDL_AudioSpec spec;
+  Uint8*        data   = nullptr;
+  Uint32        length = 0;
+  if(SDL_LoadWAV(path.c_str(), &spec, &data, &length) == nullptr)
+  {
+    *error = "Failed to load " + path + ": " + SDL_GetError();
+    return false;
+  }
+
+  SDL_AudioCVT cvt;
+  if(SDL_BuildAudioCVT(
+         &cvt,
+         spec.format,
+         spec.channels,
+         spec.freq,
+         AUDIO_F32SYS,
+         1,
+         frequency) < 0)
+  {
+    *error = "Failed to convert " + path + ": " + SDL_GetError();
+    SDL_FreeWAV(data);
+    return false;
+  }
+
+  std::vector<Uint8> converted(length * cvt.len_mult);
+  std::memcpy(converted.data(), data, length);
+  SDL_FreeWAV(data);
+  cvt.buf = converted.data();
+  cvt.len = length;
+  if(cvt.needed && SDL_ConvertAudio(&cvt) < 0)
+  {
+    *error = "Failed to convert " + path + ": " + SDL_GetError();
+    return false;
+  }
+  const int size = cvt.needed ? cvt.len_cvt : cvt.len;
+
+  buffer->samples.resize(size / sizeof(float));
+  std::memcpy(buffer->samples.data(), converted.data(), size);
+  return true;
+}
+
+AudioMixer::AudioMixer()
+    : dropped_(0)
+    , device_(0)
+    , frequency_(0)
+    , voice_count_(0)
+{
+}
+
+AudioMixer::~AudioMixer()
+{
+  Close();
+}
+
+void
+AudioMixer::SetSound(Sound sound, SoundBuffer buffer)
+{
+  ASSERT(device_ == 0);
+  ASSERT(sound != Sound::Count);
+  sounds_[static_cast<int>(sound)] = std::move(buffer);
+}
+
+bool
+AudioMixer::Open(int frequency, int buffer_samples, std::string* error)
+{
+  ASSERT(device_ == 0);
+  SDL_AudioSpec desired;
+  std::memset(&desired, 0, sizeof(desired));
+  desired.freq     = frequency;
+  desired.format   = AUDIO_F32SYS;
+  desired.channels = 2;
+  desired.samples  = buffer_samples;
+  desired.callback = &AudioMixer::Callback;
+  desired.userdata = this;
+
+  // no allowed changes, SDL converts if the device wants something else
+  SDL_AudioSpec obtained;
+  device_ = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+  if(device_ == 0)
+  {
+    *error = std::string("Failed to open audio: ") + SDL_GetError();
+    return false;
+  }
+  frequency_   = obtained.freq;
+  voice_count_ = 0;
+  SDL_PauseAudioDevice(device_, 0);
+  return true;
+}
+
+void
+AudioMixer::Close()
+{
+  if(device_ != 0)
+  {
+    SDL_CloseAudioDevice(device_);
+    device_ = 0;
+  }
+}
+
+int
+AudioMixer::GetFrequency() const
+{
+  return frequency_;
+}
+
+void
+AudioMixer::Play(Sound sound, float volume)
+{
+  ASSERT(sound != Sound::Count);
+  if(device_ == 0)
+  {
+    return;
+  }
+  if(!commands_.Push(Command{sound, volume}))
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+int
+AudioMixer::GetDropped() const
+{
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+void
+AudioMixer::Callback(void* userdata, Uint8* stream, int length)
+{
+  AudioMixer* mixer = static_cast<AudioMixer*>(userdata);
+  mixer->Mix(reinterpret_cast<float*>(stream), length / (sizeof(float) * 2));
+}
+
+void
+AudioMixer::Mix(float* out, int frames)
+{
+  Command command;
+  while(commands_.Pop(&command))
+  {
+    const SoundBuffer& sound = sounds_[static_cast<int>(command.sound)];
+    if(sound.samples.empty())
+    {
+      continue;
+    }
+    // when all voices are busy the oldest one is replaced
+    if(voice_count_ == kMaxVoices)
+    {
+      std::move(voices_ + 1, voices_ + kMaxVoices, voices_);
+      voice_count_ -= 1;
+    }
+    Voice& voice   = voices_[voice_count_];
+    voice.samples  = sound.samples.data();
+    voice.length   = sound.samples.size();
+    voice.position = 0;
+    voice.volume   = command.volume;
+    voice_count_ += 1;
+  }
+
+  std::fill(out, out + frames * 2, 0.0f);
+  for(int v = 0; v < voice_count_; ++v)
+  {
+    Voice&            voice = voices_[v];
+    const std::size_t count =
+        std::min<std::size_t>(frames, voice.length - voice.position);
+    const float* samples = voice.samples + voice.position;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      const float s = samples[i] * voice.volume;
+      out[i * 2] += s;
+      out[i * 2 + 1] += s;
+    }
+    voice.position += count;
+  }
+
+  // finished voices are removed keeping the order, oldest first
+  voice_count_ = std::remove_if(
+                     voices_,
+                     voices_ + voice_count_,
+                     [](const Voice& v) { return v.position >= v.length; }) -
+                 voices_;
+
+  for(int i = 0; i < frames * 2; ++i)
+  {
+    out[i] = std::max(-1.0f, std::min(out[i], 1.0f));
+  }
+}
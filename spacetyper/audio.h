@@ -0,0 +1,105 @@
+#ifndef SPACETYPER_AUDIO_H
+#define SPACETYPER_AUDIO_H
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "spacetyper/spscqueue.h"
+
+enum class Sound
+{
+  Shot,
+  Hit,
+  Explosion,
+  Count
+};
+
+// mono float samples at the mixer frequency
+struct SoundBuffer
+{
+  std::vector<float> samples;
+};
+
+// simple procedural effects so the game has sound without any files
+SoundBuffer
+SynthesizeSound(Sound sound, int frequency);
+
+// any wav SDL can read, converted to the mixer format
+bool
+LoadWav(
+    const std::string& path,
+    int                frequency,
+    SoundBuffer*       buffer,
+    std::string*       error);
+
+// Software mixer that runs in the SDL audio callback. The game thread only
+// pushes commands on a lock-free queue, the callback never locks or
+// allocates. The latency is about one buffer, use SDL_AUDIODRIVER=dummy or
+// disk to run without a sound card.
+class AudioMixer
+{
+ public:
+  AudioMixer();
+  ~AudioMixer();
+
+  // all sounds must be set before Open and can't change while open
+  void
+  SetSound(Sound sound, SoundBuffer buffer);
+
+  // buffer_samples is the callback size in frames, smaller is lower latency
+  bool
+  Open(int frequency, int buffer_samples, std::string* error);
+
+  void
+  Close();
+
+  int
+  GetFrequency() const;
+
+  // game thread only, never waits, the sound is skipped if the audio thread
+  // has fallen behind
+  void
+  Play(Sound sound, float volume = 1.0f);
+
+  // commands that didn't fit in the queue
+  int
+  GetDropped() const;
+
+ private:
+  struct Command
+  {
+    Sound sound;
+    float volume;
+  };
+
+  struct Voice
+  {
+    const float* samples;
+    std::size_t  length;
+    std::size_t  position;
+    float        volume;
+  };
+
+  static void
+  Callback(void* userdata, Uint8* stream, int length);
+
+  void
+  Mix(float* out, int frames);
+
+  static const int kMaxVoices = 32;
+
+  SoundBuffer             sounds_[static_cast<int>(Sound::Count)];
+  SpscQueue<Command, 256> commands_;
+  std::atomic<int>        dropped_;
+  SDL_AudioDeviceID       device_;
+  int                     frequency_;
+
+  // only touched by the audio thread while open
+  Voice voices_[kMaxVoices];
+  int   voice_count_;
+};
+
+#endif  // SPACETYPER_AUDIO_H
@@ -1,20 +1,15 @@
 #include "spacetyper/background.h"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 #include "render/spriterender.h"
 #include "render/texture.h"
 
-namespace
-{
-  std::mt19937&
-  Generator()
-  {
-    static std::random_device rd;
-    static std::mt19937       gen(rd());
-    return gen;
-  }
-}
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/culledlayer.h"
+#include "spacetyper/snapshot.h"
 
 std::uniform_real_distribution<float>
 GetDistribution(float window, float texture)
@@ -32,18 +27,23 @@ Background::Background(
     int                        height,
     std::shared_ptr<Texture2d> texture,
     float                      speed,
-    Layer*                     layer)
+    CulledLayer*               layer,
+    unsigned int               seed)
     : width_(width)
     , height_(height)
     , speed_(speed)
+    , generator_(seed)
+    , layer_(layer)
+    , visible_(count)
 {
+  const ScopedAllocationTag alloc_tag(AllocationScope::Background);
   auto rwidth  = GetDistribution(width, texture->GetWidth());
   auto rheight = GetDistribution(height, texture->GetHeight());
 
   positions_.reserve(count);
   for(int i = 0; i < count; ++i)
   {
-    vec2f  p(rwidth(Generator()), rheight(Generator()));
+    vec2f  p(rwidth(generator_), rheight(generator_));
     Sprite sp(texture, p);
     positions_.push_back(sp);
     layer->Add(&*positions_.rbegin());
@@ -53,6 +53,7 @@ Background::Background(
 void
 Background::Update(float delta)
 {
+  const ScopedAllocationTag alloc_tag(AllocationScope::Background);
   for(Sprite& sp : positions_)
   {
     vec2f p = sp.GetPosition();
@@ -62,9 +63,62 @@ Background::Update(float delta)
     {
       auto rwidth = GetDistribution(width_, sp.GetWidth());
       p.y         = height_ + sp.GetHeight() / 2;
-      p.x         = rwidth(Generator());
+      p.x         = rwidth(generator_);
     }
 
     sp.SetPosition(p);
   }
 }
+
+void
+Background::SetDensity(float density)
+{
+  const size_t visible = std::min(
+      positions_.size(),
+      static_cast<size_t>(std::ceil(positions_.size() * density)));
+  for(size_t i = visible; i < visible_; ++i)
+  {
+    layer_->Remove(&positions_[i]);
+  }
+  for(size_t i = visible_; i < visible; ++i)
+  {
+    layer_->Add(&positions_[i]);
+  }
+  visible_ = visible;
+}
+
+void
+Background::Save(SnapshotWriter* writer, int id) const
+{
+  writer->BeginRecord(SnapshotRecord::Stars, id);
+  writer->WriteGenerator(generator_);
+  writer->WriteInt(positions_.size());
+  for(const Sprite& sp : positions_)
+  {
+    writer->WriteVec2(sp.GetPosition());
+  }
+  writer->EndRecord();
+}
+
+void
+Background::Restore(SnapshotReader* reader, int id)
+{
+  if(static_cast<int>(reader->BeginRecord(SnapshotRecord::Stars)) != id)
+  {
+    reader->Fail();
+    return;
+  }
+  reader->ReadGenerator(&generator_);
+  // the layer points into positions_ so the star count can't change
+  const int count = reader->ReadCount(sizeof(vec2f));
+  if(count != static_cast<int>(positions_.size()))
+  {
+    reader->Fail();
+    return;
+  }
+  for(Sprite& sp : positions_)
+  {
+    sp.SetPosition(reader->ReadVec2());
+  }
+  reader->EndRecord();
+}
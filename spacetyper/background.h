@@ -7,20 +7,37 @@
 #include "render/sprite.h"
 #include "render/texture.h"
 
+#include "spacetyper/pcg32.h"
+
 class SpriteRenderer;
+class CulledLayer;
+class SnapshotReader;
+class SnapshotWriter;
 
 class Background {
 public:
   Background(int count, int width, int height,
-             std::shared_ptr<Texture2d> texture, float speed, Layer *layer);
+             std::shared_ptr<Texture2d> texture, float speed, CulledLayer *layer,
+             unsigned int seed);
 
   void Update(float delta);
 
+  // fraction of the stars that are in the layer, the rest still move so
+  // they come back in the right place
+  void SetDensity(float density);
+
+  // the id tells the star layers of a session apart
+  void Save(SnapshotWriter *writer, int id) const;
+  void Restore(SnapshotReader *reader, int id);
+
 private:
   float width_;
   float height_;
   float speed_;
+  Pcg32 generator_;
   std::vector<Sprite> positions_;
+  CulledLayer *layer_;
+  size_t visible_;
 };
 
 #endif // SPACETYPER_BACKGROUND_H
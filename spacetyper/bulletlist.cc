@@ -3,71 +3,72 @@
 #include <algorithm>
 
 #include "render/sprite.h"
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/culledlayer.h"
+#include "spacetyper/enemies.h"
 #include "spacetyper/enemyword.h"
+#include "spacetyper/snapshot.h"
+#include "spacetyper/trig.h"
 
 #include "core/vec2.h"
 
-// todo: improve resolution
-const float PI = 3.14;
-
 BulletType::~BulletType()
 {
 }
 
-BulletList::BulletList(Layer* layer)
+BulletList::BulletList(CulledLayer* layer)
     : layer_(layer)
+    , next_id_(0)
 {
 }
 
 Angle
-GetAngle(const vec2f& dn)
+BulletList::Add(
+    EnemyWord*                 word,
+    std::shared_ptr<Texture2d> t,
+    const vec2f&               pos,
+    int                        damage)
 {
-  float aa = dot(vec2f(0.0f, 1.0f), dn);
-  Angle a  = Acos(aa);
-  if(dn.x > 0)
-    a = -a;
-  return a;
-}
+  const ScopedAllocationTag alloc_tag(AllocationScope::BulletList);
+  ASSERT(damage > 0);
+  const Angle rotation = GetDirectionAngle(word->GetPosition() - pos);
 
-Angle
-BulletList::Add(EnemyWord* word, std::shared_ptr<Texture2d> t, const vec2f& pos)
-{
   BulletType b;
-  b.word = word;
+  b.id     = next_id_;
+  b.word   = word;
+  b.damage = damage;
   b.sprite.reset(new Sprite(t, pos));
+  b.sprite->rotation = rotation;
   layer_->Add(b.sprite.get());
   bullets_.push_back(b);
+  next_id_ = (next_id_ + 1) & kMaxRecordId;
 
-  // todo: move to core
-  const vec2f& p  = pos;
-  const vec2f& w  = word->GetPosition();
-  const vec2f  d  = w - p;
-  const vec2f  dn = d.GetNormalized();
-
-  return GetAngle(dn);
+  return rotation;
 }
 
 void
 BulletList::Update(float dt)
 {
+  const ScopedAllocationTag alloc_tag(AllocationScope::BulletList);
   const float speed = 1000.0f;
   for(BulletType& b : bullets_)
   {
     const vec2f& p = b.sprite->GetPosition();
     const vec2f& w = b.word->GetPosition();
 
-    const vec2f d = w - p;
-    if(d.GetLength() < speed * dt)
+    const vec2f d      = w - p;
+    const float length = d.GetLength();
+    if(length < speed * dt)
     {
-      b.word->Damage();
+      b.word->Damage(b.damage);
       b.word = nullptr;
       layer_->Remove(b.sprite.get());
     }
     else
     {
-      const vec2f dn = d.GetNormalized();
-      b.sprite->SetPosition(p + dn * speed * dt);
-      b.sprite->rotation = GetAngle(dn);
+      // one sqrt for both the hit test and the step
+      b.sprite->SetPosition(p + d * (speed * dt / length));
+      b.sprite->rotation = GetDirectionAngle(d);
     }
   }
 
@@ -78,3 +79,85 @@ BulletList::Update(float dt)
           [](const BulletType& b) { return b.word == nullptr; }),
       bullets_.end());
 }
+
+void
+BulletList::Save(SnapshotWriter* writer) const
+{
+  writer->BeginRecord(SnapshotRecord::Bullets, 0);
+  writer->WriteInt(static_cast<int>(next_id_));
+  writer->EndRecord();
+  for(const BulletType& b : bullets_)
+  {
+    writer->BeginRecord(SnapshotRecord::Bullet, b.id);
+    writer->WriteInt(static_cast<int>(b.word->GetId()));
+    writer->WriteInt(b.damage);
+    writer->WriteVec2(b.sprite->GetPosition());
+    writer->WriteFloat(b.sprite->rotation.InRadians());
+    writer->EndRecord();
+  }
+}
+
+void
+BulletList::Restore(
+    SnapshotReader*            reader,
+    const Enemies&             enemies,
+    std::shared_ptr<Texture2d> texture)
+{
+  const ScopedAllocationTag alloc_tag(AllocationScope::BulletList);
+  reader->BeginRecord(SnapshotRecord::Bullets);
+  next_id_ = static_cast<uint32_t>(reader->ReadInt()) & kMaxRecordId;
+  reader->EndRecord();
+
+  // all bullets look the same so keep as many of the sprites as possible
+  size_t count = 0;
+  while(reader->PeekRecord() == SnapshotRecord::Bullet)
+  {
+    if(count == bullets_.size())
+    {
+      BulletType b;
+      b.id     = 0;
+      b.word   = nullptr;
+      b.damage = 1;
+      b.sprite.reset(new Sprite(texture));
+      layer_->Add(b.sprite.get());
+      bullets_.push_back(b);
+    }
+
+    BulletType& b    = bullets_[count];
+    b.id             = reader->BeginRecord(SnapshotRecord::Bullet);
+    const int target = reader->ReadInt();
+    b.damage         = reader->ReadInt();
+    b.sprite->SetPosition(reader->ReadVec2());
+    b.sprite->rotation = Angle::FromRadians(reader->ReadFloat());
+    reader->EndRecord();
+    b.word = target >= 0 ? enemies.FindEnemy(target) : nullptr;
+    count += 1;
+    if(b.word == nullptr || b.damage <= 0)
+    {
+      reader->Fail();
+      break;
+    }
+  }
+
+  // bullets must have a target, drop them all rather than crash later
+  if(reader->IsOk() == false)
+  {
+    count = 0;
+  }
+  if(bullets_.size() > count)
+  {
+    std::vector<Sprite*> removed;
+    for(auto it = bullets_.begin() + count; it != bullets_.end(); ++it)
+    {
+      removed.push_back(it->sprite.get());
+    }
+    layer_->Remove(removed);
+    bullets_.resize(count);
+  }
+}
+
+int
+BulletList::GetCount() const
+{
+  return static_cast<int>(bullets_.size());
+}
@@ -1,6 +1,7 @@
 #ifndef SPACETYPER_BULLETLIST_H
 #define SPACETYPER_BULLETLIST_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -9,8 +10,11 @@
 
 #include "render/sprite.h"
 
+class Enemies;
 class EnemyWord;
-class Layer;
+class CulledLayer;
+class SnapshotReader;
+class SnapshotWriter;
 
 class BulletType
 {
@@ -19,23 +23,44 @@ class BulletType
 
   ~BulletType();
 
+  // stays the same for the life of the bullet, snapshots are keyed by it
+  uint32_t   id;
   EnemyWord* word;
   SpritePtr  sprite;
+  // one per character it was fired for
+  int damage;
 };
 
 class BulletList
 {
  public:
-  explicit BulletList(Layer* layer);
+  explicit BulletList(CulledLayer* layer);
   Angle
-  Add(EnemyWord* word, std::shared_ptr<Texture2d> t, const vec2f& pos);
+  Add(EnemyWord*                 word,
+      std::shared_ptr<Texture2d> t,
+      const vec2f&               pos,
+      int                        damage);
   void
   Update(float d);
 
+  // bullet targets are stored as enemy ids, so the enemies are restored
+  // first
+  void
+  Save(SnapshotWriter* writer) const;
+  void
+  Restore(
+      SnapshotReader*            reader,
+      const Enemies&             enemies,
+      std::shared_ptr<Texture2d> texture);
+
+  int
+  GetCount() const;
+
  private:
-  Layer*                          layer_;
+  CulledLayer*                    layer_;
   typedef std::vector<BulletType> Bullets;
   Bullets                         bullets_;
+  uint32_t                        next_id_;
 };
 
 #endif  // SPACETYPER_BULLETLIST_H
@@ -0,0 +1,144 @@
+#include "spacetyper/culledlayer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "spacetyper/rendercommands.h"
+
+CullStats::CullStats()
+    : drawn(0)
+    , culled(0)
+{
+}
+
+void
+CullStats::Reset()
+{
+  drawn  = 0;
+  culled = 0;
+}
+
+bool
+IsInsideScreen(
+    float left,
+    float right,
+    float bottom,
+    float top,
+    float width,
+    float height)
+{
+  return right >= 0.0f && left <= width && top >= 0.0f && bottom <= height;
+}
+
+CulledLayer::CulledLayer(SpriteRenderer* renderer, float width, float height)
+    : renderer_(renderer)
+    , width_(width)
+    , height_(height)
+{
+}
+
+void
+CulledLayer::Add(Sprite* sprite, const float* alpha)
+{
+  ASSERT(sprite);
+  const float w = sprite->GetWidth();
+  const float h = sprite->GetHeight();
+  Entry       e;
+  e.sprite  = sprite;
+  e.texture = sprite->GetTexture().get();
+  e.alpha   = alpha;
+  e.radius  = std::sqrt(w * w + h * h) / 2.0f;
+  entries_.push_back(e);
+}
+
+void
+CulledLayer::Remove(Sprite* sprite)
+{
+  auto found = std::find_if(
+      entries_.begin(), entries_.end(), [sprite](const Entry& e) {
+        return e.sprite == sprite;
+      });
+  ASSERT(found != entries_.end());
+  entries_.erase(found);
+}
+
+void
+CulledLayer::Remove(const std::vector<Sprite*>& sprites)
+{
+  std::vector<Sprite*> sorted = sprites;
+  std::sort(sorted.begin(), sorted.end());
+
+  std::size_t removed = 0;
+  auto        end     = std::remove_if(
+      entries_.begin(), entries_.end(), [&](const Entry& e) {
+        if(std::binary_search(sorted.begin(), sorted.end(), e.sprite) == false)
+        {
+          return false;
+        }
+        removed += 1;
+        return true;
+      });
+  ASSERT(removed == sorted.size());
+  entries_.erase(end, entries_.end());
+}
+
+void
+CulledLayer::Render()
+{
+  // the sprites are drawn straight from the entries so the order is the
+  // same as when recording, whatever went off and on screen in between
+  stats_.Reset();
+  for(const Entry& e : entries_)
+  {
+    if(IsVisible(e))
+    {
+      e.sprite->Render(renderer_);
+    }
+  }
+}
+
+void
+CulledLayer::Record(std::vector<SpriteCommand>* sprites)
+{
+  stats_.Reset();
+  for(const Entry& e : entries_)
+  {
+    if(IsVisible(e))
+    {
+      sprites->push_back(SpriteCommand{e.texture,
+                                       e.sprite->GetPosition(),
+                                       e.sprite->rotation,
+                                       e.alpha == nullptr ? 1.0f : *e.alpha});
+    }
+  }
+}
+
+const CullStats&
+CulledLayer::GetStats() const
+{
+  return stats_;
+}
+
+bool
+CulledLayer::IsVisible(const Entry& e)
+{
+  const vec2f& p       = e.sprite->GetPosition();
+  const float  r       = e.radius;
+  const bool   visible = IsInsideScreen(
+      p.x - r, p.x + r, p.y - r, p.y + r, width_, height_);
+  if(visible)
+  {
+    stats_.drawn += 1;
+  }
+  else
+  {
+    stats_.culled += 1;
+  }
+  return visible;
+}
+
+int
+CulledLayer::GetCount() const
+{
+  return static_cast<int>(entries_.size());
+}
@@ -0,0 +1,85 @@
+#ifndef SPACETYPER_CULLEDLAYER_H
+#define SPACETYPER_CULLEDLAYER_H
+
+#include <vector>
+
+#include "render/sprite.h"
+
+class SpriteRenderer;
+class Texture2d;
+struct SpriteCommand;
+
+// how many items were submitted versus skipped in the last render
+struct CullStats
+{
+  CullStats();
+
+  void
+  Reset();
+
+  int drawn;
+  int culled;
+};
+
+bool
+IsInsideScreen(
+    float left,
+    float right,
+    float bottom,
+    float top,
+    float width,
+    float height);
+
+// a layer that only submits the sprites that overlap the screen, in the
+// order they were added
+class CulledLayer
+{
+ public:
+  CulledLayer(SpriteRenderer* renderer, float width, float height);
+
+  // alpha is the value last given to Sprite::SetAlpha, owned by the caller
+  // and valid while the sprite is in the layer, null for opaque sprites
+  void
+  Add(Sprite* sprite, const float* alpha = nullptr);
+  void
+  Remove(Sprite* sprite);
+  // removes many sprites in a single pass
+  void
+  Remove(const std::vector<Sprite*>& sprites);
+
+  void
+  Render();
+
+  // same as Render but records the visible sprites for the render thread
+  void
+  Record(std::vector<SpriteCommand>* sprites);
+
+  const CullStats&
+  GetStats() const;
+
+  // all sprites, visible or not
+  int
+  GetCount() const;
+
+ private:
+  struct Entry
+  {
+    Sprite*          sprite;
+    const Texture2d* texture;
+    const float*     alpha;
+    // cached bounds, half the diagonal so rotated sprites are covered
+    float radius;
+  };
+
+  // also counts the sprite in the stats
+  bool
+  IsVisible(const Entry& e);
+
+  SpriteRenderer*    renderer_;
+  float              width_;
+  float              height_;
+  std::vector<Entry> entries_;
+  CullStats          stats_;
+};
+
+#endif  // SPACETYPER_CULLEDLAYER_H
@@ -1,8 +1,30 @@
 #include "spacetyper/dictionary.h"
 
-Dictionary::Dictionary() : adjectives_("wordlist_adjective.txt"), nouns_("wordlist_noun.txt") {
+Dictionary::Dictionary() {
+  lists_.push_back(Wordlist("wordlist_adjective.txt"));
+  lists_.push_back(Wordlist("wordlist_noun.txt"));
 }
 
-std::string Dictionary::Generate() const {
-  return adjectives_.RandomWord() + " " + nouns_.RandomWord();
+Dictionary::Dictionary(const std::string& wordlist) {
+  lists_.push_back(Wordlist(wordlist));
+}
+
+bool Dictionary::IsEmpty() const {
+  for(const Wordlist& list : lists_) {
+    if( list.IsEmpty() ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string Dictionary::Generate(std::mt19937* generator) const {
+  std::string word;
+  for(const Wordlist& list : lists_) {
+    if( !word.empty() ) {
+      word += " ";
+    }
+    word += list.RandomWord(generator);
+  }
+  return word;
 }
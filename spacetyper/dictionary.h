@@ -1,16 +1,24 @@
 #ifndef SPACETYPER_DICTIONARY_H
 #define SPACETYPER_DICTIONARY_H
 
+#include <vector>
+
 #include "spacetyper/wordlist.h"
 
 class Dictionary {
  public:
+  // adjective noun pairs
   Dictionary();
+  // single words from a list, for example one made by wordscan
+  explicit Dictionary(const std::string& wordlist);
+
+  // true if a list has no words, Generate can't be used then
+  bool IsEmpty() const;
 
-  std::string Generate() const;
+  std::string Generate(std::mt19937* generator) const;
  private:
-  Wordlist adjectives_;
-  Wordlist nouns_;
+  // one word from each list separated by a space
+  std::vector<Wordlist> lists_;
 };
 
-#endif  //  SPACETYPER_DICTIONARY_H
\ No newline at end of file
+#endif  //  SPACETYPER_DICTIONARY_H
@@ -1,77 +1,163 @@
 #include "spacetyper/enemies.h"
 
 #include <algorithm>
+#include <map>
 
-#include "render/texturecache.h"
-
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/audio.h"
 #include "spacetyper/bulletlist.h"
-#include "spacetyper/dictionary.h"
 #include "spacetyper/enemyword.h"
+#include "spacetyper/gameassets.h"
+#include "spacetyper/rendercommands.h"
+#include "spacetyper/snapshot.h"
+
+namespace
+{
+  // a bit bigger than an enemy ship
+  const float kGridCellSize = 128.0f;
+}
 
 Enemies::Enemies(
-    SpriteFader*  fader,
-    TextureCache* cache,
-    Font*         font,
-    Layer*        layer,
-    Dictionary*   dictionary,
-    float         width,
-    float         height,
-    BulletList*   bullets)
+    SpriteFader*      fader,
+    TimerWheel*       timers,
+    const GameAssets* assets,
+    CulledLayer*      layer,
+    const Dictionary* dictionary,
+    float             width,
+    float             height,
+    BulletList*       bullets,
+    unsigned int      seed)
     : fader_(fader)
-    , generator_(std::random_device()())
-    , cache_(cache)
-    , font_(font)
+    , timers_(timers)
+    , audio_(nullptr)
+    , prefetcher_(fader, timers, assets, dictionary, width, height, seed)
+    , assets_(assets)
     , layer_(layer)
-    , dictionary_(dictionary)
     , width_(width)
     , height_(height)
     , spawn_count_(0)
-    , spawn_time_(-1.0f)
+    , spawn_interval_(1.0f)
+    , spawn_timer_(0)
+    , next_spawn_(0.0)
+    , label_backgrounds_(true)
+    , next_label_(0)
+    , grid_(kGridCellSize)
+    , grid_dirty_(true)
     , bullets_(bullets)
 {
-  ASSERT(cache);
-  ASSERT(font);
+  ASSERT(timers);
+  ASSERT(assets);
   ASSERT(layer);
 }
 
 Enemies::~Enemies()
 {
+  timers_->Cancel(spawn_timer_);
+}
+
+void
+Enemies::SetAudio(AudioMixer* audio)
+{
+  audio_ = audio;
+  for(auto& e : enemies_)
+  {
+    e->SetAudio(audio);
+  }
+  for(auto& e : destroyed_)
+  {
+    e->SetAudio(audio);
+  }
+}
+
+void
+Enemies::SetLabelBackgrounds(bool enabled)
+{
+  if(label_backgrounds_ == enabled)
+  {
+    return;
+  }
+  label_backgrounds_ = enabled;
+  for(auto& e : enemies_)
+  {
+    e->SetLabelBackground(enabled);
+  }
+}
+
+bool
+Enemies::HasLabelBackgrounds() const
+{
+  return label_backgrounds_;
+}
+
+void
+Enemies::StartPrefetch()
+{
+  prefetcher_.Start();
 }
 
 void
 Enemies::SpawnEnemies(int count)
 {
   spawn_count_ += count;
+  ScheduleSpawn();
 }
 
-std::string
-GenerateUniqueWord(const std::string& start, Dictionary* dict)
+void
+Enemies::SetSpawnInterval(float seconds)
 {
-  std::string  word = dict->Generate();
-  unsigned int loop = 0;
-  while(start.find(word[0]) != std::string::npos && loop < 10)
+  ASSERT(seconds >= 0.0f);
+  spawn_interval_ = seconds;
+}
+
+void
+Enemies::ScheduleSpawn()
+{
+  if(spawn_count_ <= 0 || timers_->IsPending(spawn_timer_))
   {
-    word = dict->Generate();
-    ++loop;
+    return;
   }
-  return word;
+  const double delay = std::max(0.0, next_spawn_ - timers_->GetTime());
+  spawn_timer_ = timers_->Schedule(delay, [this]() { Spawn(); });
+}
+
+void
+Enemies::Spawn()
+{
+  spawn_timer_ = 0;
+  AddEnemy();
+  spawn_count_ -= 1;
+  // the next wave may start right away
+  next_spawn_ =
+      timers_->GetTime() + (spawn_count_ > 0 ? spawn_interval_ : 0.0);
+  ScheduleSpawn();
 }
 
 void
 Enemies::AddEnemy()
 {
+  const ScopedAllocationTag alloc_tag(AllocationScope::Enemies);
   std::string characters;
   for(auto& w : enemies_)
   {
     characters += w->GetWord()[0];
   }
 
-  EnemyPtr e(new EnemyWord(
-      fader_, cache_, font_, GenerateUniqueWord(characters, dictionary_)));
+  // the spawns come ready rolled, skip the ones that start with a letter
+  // that is already taken before paying for the label
+  EnemySpawn   spawn = prefetcher_.Take();
+  unsigned int loop  = 0;
+  while(characters.find(spawn.word[0]) != std::string::npos && loop < 10)
+  {
+    spawn = prefetcher_.Take();
+    ++loop;
+  }
+  EnemyPtr e = prefetcher_.Create(spawn);
+  e->SetAudio(audio_);
+  e->SetLabelBackground(label_backgrounds_);
   e->AddSprite(layer_);
-  e->Setup(&generator_, width_, height_);
   e->Update(0.0f);
   enemies_.push_back(e);
+  grid_dirty_ = true;
 }
 
 int
@@ -80,9 +166,24 @@ Enemies::EnemyCount()
   return enemies_.size();
 }
 
+EnemyWord*
+Enemies::GetLowest()
+{
+  EnemyWord* lowest = nullptr;
+  for(auto& e : enemies_)
+  {
+    if(lowest == nullptr || e->GetPosition().y < lowest->GetPosition().y)
+    {
+      lowest = e.get();
+    }
+  }
+  return lowest;
+}
+
 void
 Enemies::Update(float delta)
 {
+  const ScopedAllocationTag alloc_tag(AllocationScope::Enemies);
   for(auto& e : enemies_)
   {
     e->Update(delta);
@@ -93,39 +194,226 @@ Enemies::Update(float delta)
     e->Update(delta);
   }
 
-  if(spawn_count_ > 0)
+  destroyed_.erase(
+      std::remove_if(
+          destroyed_.begin(),
+          destroyed_.end(),
+          [](EnemyPtr enemy) { return enemy->IsDestroyed(); }),
+      destroyed_.end());
+  grid_dirty_ = true;
+}
+
+void
+Enemies::BuildGrid()
+{
+  // the destroyed enemies are included since bullets still fly at them
+  grid_dirty_ = false;
+  grid_.Clear();
+  ListEnemies(&grid_enemies_);
+  for(EnemyWord* e : grid_enemies_)
+  {
+    const Sizef size = e->GetSize();
+    grid_.Add(
+        e->GetPosition(), size.GetWidth() / 2.0f, size.GetHeight() / 2.0f);
+  }
+  grid_.Build();
+}
+
+void
+Enemies::Collide(
+    const std::vector<GridCircle>& circles, std::vector<GridHit>* hits)
+{
+  if(grid_dirty_)
+  {
+    BuildGrid();
+  }
+  grid_.Query(circles, hits);
+}
+
+EnemyWord*
+Enemies::GetGridEnemy(int id) const
+{
+  ASSERT(id >= 0 && id < static_cast<int>(grid_enemies_.size()));
+  return grid_enemies_[id];
+}
+
+void
+SaveEnemyList(
+    SnapshotWriter*                                writer,
+    const std::vector<std::shared_ptr<EnemyWord>>& list,
+    bool                                           destroyed)
+{
+  for(const auto& e : list)
+  {
+    writer->BeginRecord(SnapshotRecord::Enemy, e->GetId());
+    writer->WriteInt(destroyed ? 1 : 0);
+    writer->WriteString(e->GetWord());
+    e->Save(writer);
+    writer->EndRecord();
+  }
+}
+
+void
+Enemies::Save(SnapshotWriter* writer) const
+{
+  writer->BeginRecord(SnapshotRecord::Enemies, 0);
+  writer->WriteInt(static_cast<int>(prefetcher_.GetSeed()));
+  writer->WriteInt(prefetcher_.GetIndex());
+  writer->WriteInt(spawn_count_);
+  writer->WriteFloat(std::max(0.0, next_spawn_ - timers_->GetTime()));
+  writer->EndRecord();
+  SaveEnemyList(writer, enemies_, false);
+  SaveEnemyList(writer, destroyed_, true);
+}
+
+void
+Enemies::Restore(SnapshotReader* reader)
+{
+  const ScopedAllocationTag alloc_tag(AllocationScope::Enemies);
+  reader->BeginRecord(SnapshotRecord::Enemies);
+  const unsigned int seed  = static_cast<unsigned int>(reader->ReadInt());
+  const int          index = reader->ReadInt();
+  spawn_count_             = reader->ReadInt();
+  const float next_spawn   = reader->ReadFloat();
+  reader->EndRecord();
+  if(index < 0)
   {
-    spawn_time_ -= delta;
-    if(spawn_time_ < 0)
+    reader->Fail();
+    return;
+  }
+  prefetcher_.Seek(seed, index);
+  grid_dirty_ = true;
+  next_spawn_ = timers_->GetTime() + std::max(0.0f, next_spawn);
+  timers_->Cancel(spawn_timer_);
+  spawn_timer_ = 0;
+  ScheduleSpawn();
+
+  // creating the text is the expensive part, so keep the old enemies around
+  // and reuse the ones that are still there
+  std::map<uint32_t, EnemyPtr> old;
+  for(EnemyList* list : {&enemies_, &destroyed_})
+  {
+    for(auto& e : *list)
     {
-      AddEnemy();
-      spawn_count_ -= 1;
-      if(spawn_count_ > 0)
+      old.insert(std::make_pair(e->GetId(), e));
+    }
+    list->clear();
+  }
+
+  while(reader->PeekRecord() == SnapshotRecord::Enemy)
+  {
+    const uint32_t    id        = reader->BeginRecord(SnapshotRecord::Enemy);
+    const int         destroyed = reader->ReadInt();
+    const std::string word      = reader->ReadString();
+    if(word.empty() || destroyed < 0 || destroyed > 1)
+    {
+      reader->Fail();
+      break;
+    }
+
+    EnemyPtr   e;
+    const auto found = old.find(id);
+    if(found != old.end() && found->second->GetWord() == word)
+    {
+      e = found->second;
+      old.erase(found);
+    }
+    else
+    {
+      e.reset(new EnemyWord(fader_, timers_, assets_, id, word));
+      e->SetAudio(audio_);
+      e->SetLabelBackground(label_backgrounds_);
+      e->AddSprite(layer_);
+    }
+    e->Restore(reader);
+    reader->EndRecord();
+    (destroyed != 0 ? destroyed_ : enemies_).push_back(e);
+  }
+}
+
+EnemyWord*
+Enemies::FindEnemy(uint32_t id) const
+{
+  for(const EnemyList* list : {&enemies_, &destroyed_})
+  {
+    for(const auto& e : *list)
+    {
+      if(e->GetId() == id)
       {
-        spawn_time_ += 1;
+        return e.get();
       }
     }
   }
+  return nullptr;
+}
 
-  destroyed_.erase(
-      std::remove_if(
-          destroyed_.begin(),
-          destroyed_.end(),
-          [](EnemyPtr enemy) { return enemy->IsDestroyed(); }),
-      destroyed_.end());
+void
+Enemies::ListEnemies(std::vector<EnemyWord*>* enemies) const
+{
+  ASSERT(enemies);
+  enemies->clear();
+  enemies->reserve(enemies_.size() + destroyed_.size());
+  for(const auto& e : enemies_)
+  {
+    enemies->push_back(e.get());
+  }
+  for(const auto& e : destroyed_)
+  {
+    enemies->push_back(e.get());
+  }
 }
 
 void
 Enemies::Render(SpriteRenderer* renderer)
 {
+  label_stats_.Reset();
+  for(auto& e : enemies_)
+  {
+    if(e->IsVisible(width_, height_))
+    {
+      e->Render(renderer);
+      label_stats_.drawn += 1;
+    }
+    else
+    {
+      label_stats_.culled += 1;
+    }
+  }
+}
+
+void
+Enemies::Record(
+    std::vector<LabelCommand>* labels, std::vector<LabelWordCommand>* words)
+{
+  label_stats_.Reset();
   for(auto& e : enemies_)
   {
-    e->Render(renderer);
+    if(e->IsVisible(width_, height_))
+    {
+      e->RecordLabel(labels, words, &next_label_);
+      label_stats_.drawn += 1;
+    }
+    else
+    {
+      e->SkipLabel();
+      label_stats_.culled += 1;
+    }
+  }
+  // a restore can bring a destroyed enemy back
+  for(auto& e : destroyed_)
+  {
+    e->SkipLabel();
   }
 }
 
+const CullStats&
+Enemies::GetLabelStats() const
+{
+  return label_stats_;
+}
+
 EnemyWord*
-Enemies::DetectWord(const std::string& input)
+Enemies::DetectWord(char32_t input)
 {
   for(EnemyList::iterator it = enemies_.begin(); it != enemies_.end(); ++it)
   {
@@ -135,6 +423,7 @@ Enemies::DetectWord(const std::string& input)
       // move to back = move rendering to front
       enemies_.erase(it);
       enemies_.push_back(e);
+      grid_dirty_ = true;
       return e.get();
     }
   }
@@ -153,10 +442,15 @@ Enemies::Remove(EnemyWord* word)
   ASSERT(found != enemies_.end());
   destroyed_.push_back(*found);
   enemies_.erase(found);
+  grid_dirty_ = true;
 }
 
 Angle
-Enemies::FireAt(const vec2f& pos, EnemyWord* word)
+Enemies::FireAt(const vec2f& pos, EnemyWord* word, int damage)
 {
-  return bullets_->Add(word, cache_->GetTexture("laserBlue07.png"), pos);
+  if(audio_ != nullptr)
+  {
+    audio_->Play(Sound::Shot);
+  }
+  return bullets_->Add(word, assets_->bullet, pos, damage);
 }
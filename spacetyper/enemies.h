@@ -1,78 +1,156 @@
 #ifndef SPACETYPER_ENEMIES_H
 #define SPACETYPER_ENEMIES_H
 
+#include <cstdint>
 #include <vector>
 #include <memory>
-#include <random>
 #include <string>
 
 #include "core/vec2.h"
 #include "core/angle.h"
 
+#include "spacetyper/culledlayer.h"
+#include "spacetyper/enemyprefetcher.h"
+#include "spacetyper/spatialgrid.h"
+#include "spacetyper/timerwheel.h"
+
+class AudioMixer;
 class EnemyWord;
-class TextureCache;
-class Font;
-class Layer;
+class GameAssets;
+class CulledLayer;
 class Dictionary;
 class Sprite;
 class BulletList;
 class SpriteFader;
 class SpriteRenderer;
+class SnapshotReader;
+class SnapshotWriter;
+struct LabelCommand;
+struct LabelWordCommand;
 
 class Enemies
 {
  public:
   Enemies(
-      SpriteFader*  fader,
-      TextureCache* cache,
-      Font*         font,
-      Layer*        layer,
-      Dictionary*   dictionary,
-      float         width,
-      float         height,
-      BulletList*   bullets);
+      SpriteFader*      fader,
+      TimerWheel*       timers,
+      const GameAssets* assets,
+      CulledLayer*      layer,
+      const Dictionary* dictionary,
+      float             width,
+      float             height,
+      BulletList*       bullets,
+      unsigned int      seed);
   ~Enemies();
 
+  // may be null
+  void
+  SetAudio(AudioMixer* audio);
+
+  void
+  SetLabelBackgrounds(bool enabled);
+  bool
+  HasLabelBackgrounds() const;
+
+  // creates the upcoming enemies on a worker thread, the enemies are the
+  // same as without it
+  void
+  StartPrefetch();
+
   void
   SpawnEnemies(int count);
+  // seconds between two enemies of the same wave
+  void
+  SetSpawnInterval(float seconds);
 
   void
   AddEnemy();
   int
   EnemyCount();
 
+  // the enemy that is closest to reaching the player or null
+  EnemyWord*
+  GetLowest();
+
   void
   Update(float delta);
 
+  // overlaps with the enemies as they are now, the grid is only rebuilt
+  // when something is asked after the enemies moved, the ids are valid
+  // until the enemies change
+  void
+  Collide(const std::vector<GridCircle>& circles, std::vector<GridHit>* hits);
+  EnemyWord*
+  GetGridEnemy(int id) const;
+
+  void
+  Save(SnapshotWriter* writer) const;
+  // enemies with the same id are reused instead of recreated
+  void
+  Restore(SnapshotReader* reader);
+
+  // null if there is no enemy with the id, destroyed ones included
+  EnemyWord*
+  FindEnemy(uint32_t id) const;
+
+  // the enemies followed by the destroyed ones that are still exploding
+  void
+  ListEnemies(std::vector<EnemyWord*>* enemies) const;
+
   void
   Render(SpriteRenderer* renderer);
 
+  // same as Render but records the labels for the render thread
+  void
+  Record(
+      std::vector<LabelCommand>* labels, std::vector<LabelWordCommand>* words);
+
+  const CullStats&
+  GetLabelStats() const;
+
   EnemyWord*
-  DetectWord(const std::string& input);
+  DetectWord(char32_t input);
   void
   Remove(EnemyWord* word);
 
   Angle
-  FireAt(const vec2f& pos, EnemyWord* word);
+  FireAt(const vec2f& pos, EnemyWord* word, int damage);
 
  private:
-  SpriteFader*         fader_;
-  mutable std::mt19937 generator_;
-  TextureCache*        cache_;
-  Font*                font_;
-  Layer*               layer_;
-  Dictionary*          dictionary_;
-  float                width_;
-  float                height_;
+  void
+  ScheduleSpawn();
+  void
+  Spawn();
+  void
+  BuildGrid();
+
+  SpriteFader*      fader_;
+  TimerWheel*       timers_;
+  AudioMixer*       audio_;
+  EnemyPrefetcher   prefetcher_;
+  const GameAssets* assets_;
+  CulledLayer*      layer_;
+  float             width_;
+  float             height_;
 
-  int   spawn_count_;
-  float spawn_time_;
+  int     spawn_count_;
+  float   spawn_interval_;
+  TimerId spawn_timer_;
+  // earliest time the next enemy may spawn
+  double next_spawn_;
+  bool   label_backgrounds_;
 
 
   typedef std::shared_ptr<EnemyWord> EnemyPtr;
   typedef std::vector<EnemyPtr>      EnemyList;
   EnemyList                          enemies_;
   EnemyList                          destroyed_;
+  CullStats                          label_stats_;
+  int                                next_label_;
+
+  SpatialGrid             grid_;
+  std::vector<EnemyWord*> grid_enemies_;
+  bool                    grid_dirty_;
 
   BulletList* bullets_;
 };
@@ -0,0 +1,187 @@
+#include "spacetyper/enemyprefetcher.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+#include "core/assert.h"
+
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/dictionary.h"
+#include "spacetyper/enemyword.h"
+#include "spacetyper/snapshot.h"
+
+namespace
+{
+  // a big wave takes a few enemies every frame
+  const std::size_t kCapacity = 64;
+}
+
+EnemyPrefetcher::EnemyPrefetcher(
+    SpriteFader*      fader,
+    TimerWheel*       timers,
+    const GameAssets* assets,
+    const Dictionary* dictionary,
+    float             width,
+    float             height,
+    unsigned int      seed)
+    : fader_(fader)
+    , timers_(timers)
+    , assets_(assets)
+    , dictionary_(dictionary)
+    , width_(width)
+    , height_(height)
+    , seed_(seed)
+    , index_(0)
+    , next_index_(0)
+    , running_(false)
+{
+  ASSERT(dictionary);
+}
+
+EnemyPrefetcher::~EnemyPrefetcher()
+{
+  Stop();
+}
+
+void
+EnemyPrefetcher::Start()
+{
+  ASSERT(!thread_.joinable());
+  running_ = true;
+  thread_  = std::thread{&EnemyPrefetcher::Run, this};
+}
+
+void
+EnemyPrefetcher::Stop()
+{
+  if(thread_.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    space_.notify_one();
+    thread_.join();
+  }
+}
+
+EnemySpawn
+EnemyPrefetcher::Take()
+{
+  bool       found = false;
+  EnemySpawn spawn;
+  int        index = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while(!found && !ready_.empty())
+    {
+      // the game thread rolled the stale ones itself while the worker was
+      // busy with them
+      Item& item = ready_.front();
+      if(item.seed == seed_ && item.index == index_)
+      {
+        spawn = std::move(item.spawn);
+        found = true;
+      }
+      ready_.pop_front();
+    }
+    index = index_;
+    index_ += 1;
+    next_index_ = std::max(next_index_, index_);
+  }
+  space_.notify_one();
+
+  if(!found)
+  {
+    spawn = Roll(seed_, index);
+  }
+  return spawn;
+}
+
+EnemyPrefetcher::EnemyPtr
+EnemyPrefetcher::Create(const EnemySpawn& spawn) const
+{
+  const ScopedAllocationTag alloc_tag(AllocationScope::Enemies);
+
+  EnemyPtr enemy{new EnemyWord(fader_, timers_, assets_, spawn.id, spawn.word)};
+  enemy->Setup(spawn.placement, spawn.speed, width_, height_);
+  return enemy;
+}
+
+void
+EnemyPrefetcher::Seek(unsigned int seed, int index)
+{
+  ASSERT(index >= 0);
+  if(seed == seed_ && index == index_)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    seed_       = seed;
+    index_      = index;
+    next_index_ = index;
+    ready_.clear();
+  }
+  space_.notify_one();
+}
+
+unsigned int
+EnemyPrefetcher::GetSeed() const
+{
+  return seed_;
+}
+
+int
+EnemyPrefetcher::GetIndex() const
+{
+  return index_;
+}
+
+EnemySpawn
+EnemyPrefetcher::Roll(unsigned int seed, int index) const
+{
+  const ScopedAllocationTag alloc_tag(AllocationScope::Enemies);
+  std::seed_seq seeds{seed, static_cast<unsigned int>(index)};
+  std::mt19937  generator{seeds};
+
+  std::uniform_real_distribution<float> placement(0.0f, 1.0f);
+  std::uniform_real_distribution<float> speed(20.0f, 40.0f);
+
+  EnemySpawn spawn;
+  spawn.id        = static_cast<uint32_t>(index) & kMaxRecordId;
+  spawn.word      = dictionary_->Generate(&generator);
+  spawn.placement = placement(generator);
+  spawn.speed     = speed(generator);
+  return spawn;
+}
+
+void
+EnemyPrefetcher::Run()
+{
+  for(;;)
+  {
+    unsigned int seed  = 0;
+    int          index = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      space_.wait(lock, [this]() {
+        return ready_.size() < kCapacity || !running_;
+      });
+      if(!running_)
+      {
+        break;
+      }
+      seed  = seed_;
+      index = next_index_;
+      next_index_ += 1;
+    }
+
+    // a seek while rolling it makes it stale, Take throws it away
+    Item item{Roll(seed, index), seed, index};
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.push_back(std::move(item));
+  }
+}
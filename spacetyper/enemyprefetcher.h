@@ -0,0 +1,116 @@
+#ifndef SPACETYPER_ENEMYPREFETCHER_H
+#define SPACETYPER_ENEMYPREFETCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Dictionary;
+class EnemyWord;
+class GameAssets;
+class SpriteFader;
+class TimerWheel;
+
+// everything about an enemy that is decided before it is created
+struct EnemySpawn
+{
+  uint32_t    id;
+  std::string word;
+  // see EnemyWord::Setup
+  float placement;
+  float speed;
+};
+
+// The stream of enemies a session spawns. Enemy i only depends on the seed
+// and i, so a worker thread can roll the next enemies ahead of time, with
+// the word picked and the spawn position and speed decided. The font is
+// not safe to use from two threads, so the enemy and its label are created
+// on the game thread. Without the worker, or when it has fallen behind, the
+// spawn is rolled when it is taken and is the same as the worker would
+// have made.
+class EnemyPrefetcher
+{
+ public:
+  typedef std::shared_ptr<EnemyWord> EnemyPtr;
+
+  EnemyPrefetcher(
+      SpriteFader*      fader,
+      TimerWheel*       timers,
+      const GameAssets* assets,
+      const Dictionary* dictionary,
+      float             width,
+      float             height,
+      unsigned int      seed);
+  ~EnemyPrefetcher();
+
+  void
+  Start();
+
+  void
+  Stop();
+
+  // game thread from here on
+  EnemySpawn
+  Take();
+
+  // lays out the label, the enemy is not added to any layer
+  EnemyPtr
+  Create(const EnemySpawn& spawn) const;
+
+  // restoring a snapshot moves the stream, the enemies made for the old
+  // position are thrown away
+  void
+  Seek(unsigned int seed, int index);
+
+  unsigned int
+  GetSeed() const;
+
+  // the index of the next enemy to be taken
+  int
+  GetIndex() const;
+
+ private:
+  struct Item
+  {
+    EnemySpawn   spawn;
+    unsigned int seed;
+    int          index;
+  };
+
+  // doesn't touch anything but the dictionary, which is never changed
+  EnemySpawn
+  Roll(unsigned int seed, int index) const;
+
+  void
+  Run();
+
+  SpriteFader*      fader_;
+  TimerWheel*       timers_;
+  const GameAssets* assets_;
+  const Dictionary* dictionary_;
+  float             width_;
+  float             height_;
+
+  // only written by the game thread, and then with the mutex
+  unsigned int seed_;
+  int          index_;
+
+  // the worker holds the mutex only to reserve and to hand over a spawn
+  std::mutex       mutex_;
+  std::deque<Item> ready_;
+  // the next enemy the worker should make
+  int next_index_;
+  // the worker sleeps on it while the queue is full, taking or throwing
+  // away spawns and stopping wake it up
+  std::condition_variable space_;
+
+  std::atomic<bool> running_;
+  std::thread       thread_;
+};
+
+#endif  // SPACETYPER_ENEMYPREFETCHER_H
@@ -1,54 +1,98 @@
 #include "spacetyper/enemyword.h"
 
-#include "render/texturecache.h"
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/audio.h"
+#include "spacetyper/culledlayer.h"
+#include "spacetyper/gameassets.h"
+#include "spacetyper/rendercommands.h"
+#include "spacetyper/snapshot.h"
 #include "spacetyper/spritefader.h"
+#include "spacetyper/textinput.h"
 
 const int max_explosions = 20;
 
+void
+SetupEnemyLabel(Text* text)
+{
+  text->SetSize(30);
+  text->SetAlignment(Align::TOP_CENTER);
+  SetEnemyLabelBackground(text, true);
+}
+
+void
+SetEnemyLabelBackground(Text* text, bool enabled)
+{
+  text->SetBackground(enabled, 0.8f);
+}
+
 EnemyWord::EnemyWord(
     SpriteFader*       fader,
-    TextureCache*      cache,
-    Font*              font,
+    TimerWheel*        timers,
+    const GameAssets*  assets,
+    uint32_t           id,
     const std::string& word)
     : fader_(fader)
-    , sprite_(cache->GetTexture("enemyShip.png"))
+    , timers_(timers)
+    , audio_(nullptr)
+    , sprite_(assets->enemy)
+    , alpha_(1.0f)
+    , id_(id)
     , word_(word)
-    , text_(font)
+    , text_(assets->font)
+    , text_size_(Sizef::FromWidthHeight(0.0f, 0.0f))
     , position_(0.0f)
     , layer_(nullptr)
     , speed_(0.0f)
     , index_(0)
-    , health_(word.length())
-    , explisiontimer_(0.0f)
+    , health_(CountUtf8(word))
+    , explosion_timer_(0)
     , explosions_(0)
-    , knockback_(-1.0f)
+    , knockback_end_(0.0)
+    , age_(0.0f)
+    , label_(-1)
+    , label_recorded_(false)
 {
+  const ScopedAllocationTag alloc_tag(AllocationScope::Text);
   ParsedText pt;
   pt.CreateText(word);
   text_.SetText(pt);
-  text_.SetSize(30);
-  text_.SetAlignment(Align::TOP_CENTER);
-  text_.SetBackground(true, 0.8f);
+  SetupEnemyLabel(&text_);
+
+  // highlighting doesn't change the extents so cache them for culling
+  const auto extents = text_.GetExtents();
+  text_size_ = Sizef::FromWidthHeight(extents.GetWidth(), extents.GetHeight());
 }
 
 EnemyWord::~EnemyWord()
 {
+  timers_->Cancel(explosion_timer_);
   RemoveSprite();
 }
 
+void
+EnemyWord::SetAudio(AudioMixer* audio)
+{
+  audio_ = audio;
+}
+
+void
+EnemyWord::SetLabelBackground(bool enabled)
+{
+  SetEnemyLabelBackground(&text_, enabled);
+}
+
 void
 EnemyWord::Setup(
-    std::mt19937* generator, float screen_width, float screen_height)
+    float placement, float speed, float screen_width, float screen_height)
 {
-  ASSERT(generator);
+  ASSERT(placement >= 0.0f && placement <= 1.0f);
 
-  const float w = std::max(sprite_.GetWidth(), text_.GetExtents().GetWidth());
-  const float x = std::uniform_real_distribution<float>(
-      w / 2.0f, screen_width - w / 2.0f)(*generator);
-  const float y = screen_height + sprite_.GetHeight() / 2.0f +
-                  text_.GetExtents().GetHeight();
+  const float w = std::max(sprite_.GetWidth(), text_size_.GetWidth());
+  const float x = w / 2.0f + placement * (screen_width - w);
+  const float y =
+      screen_height + sprite_.GetHeight() / 2.0f + text_size_.GetHeight();
 
-  speed_      = std::uniform_real_distribution<float>(20.0f, 40.0f)(*generator);
+  speed_      = speed;
   position_.x = x;
   position_.y = y;
 }
@@ -56,41 +100,111 @@ EnemyWord::Setup(
 void
 EnemyWord::Update(float delta)
 {
+  const float knockback = GetKnockback();
   const float speed =
-      knockback_ <= 0.0f ? speed_ : speed_ * (1.0f - knockback_ * 2.0f);
-  if(knockback_ > 0.0f)
-  {
-    knockback_ -= delta * 5.0f;
-  }
+      knockback <= 0.0f ? speed_ : speed_ * (1.0f - knockback * 2.0f);
 
+  age_ += delta;
   position_.y -= delta * speed;
   sprite_.SetPosition(position_);
+}
 
-  if(health_ <= 0)
+float
+EnemyWord::GetKnockback() const
+{
+  // decays with 5 per second from the last hit
+  return std::max(
+      0.0f, static_cast<float>(knockback_end_ - timers_->GetTime()) * 5.0f);
+}
+
+void
+EnemyWord::Explode()
+{
+  const float scale = 0.8f;
+  fader_->AddRandom(
+      GetPosition(),
+      0.2f,
+      sprite_.GetWidth() * scale,
+      sprite_.GetHeight() * scale);
+  ++explosions_;
+  alpha_ =
+      std::max(0.0f, 1.0f - static_cast<float>(explosions_) / max_explosions);
+  sprite_.SetAlpha(alpha_);
+
+  explosion_timer_ = 0;
+  if(explosions_ <= max_explosions)
   {
-    const float a = 1.0f - static_cast<float>(explosions_) / max_explosions;
-    sprite_.SetAlpha(a);
-    explisiontimer_ -= delta;
-    while(explisiontimer_ < 0.0f)
-    {
-      float scale = 0.8f;
-      fader_->AddRandom(
-          GetPosition(),
-          0.2f,
-          sprite_.GetWidth() * scale,
-          sprite_.GetHeight() * scale);
-      ++explosions_;
-      explisiontimer_ += 0.05f;
-    }
+    explosion_timer_ = timers_->Schedule(0.05f, [this]() { Explode(); });
   }
 }
 
 void
-EnemyWord::AddSprite(Layer* layer)
+EnemyWord::Save(SnapshotWriter* writer) const
+{
+  writer->WriteInt(index_);
+  writer->WriteVec2(position_);
+  writer->WriteFloat(speed_);
+  writer->WriteInt(health_);
+  // -1 when no explosion is pending
+  writer->WriteFloat(
+      timers_->IsPending(explosion_timer_)
+          ? timers_->GetRemaining(explosion_timer_)
+          : -1.0f);
+  writer->WriteInt(explosions_);
+  writer->WriteFloat(GetKnockback());
+  writer->WriteFloat(age_);
+}
+
+void
+EnemyWord::Restore(SnapshotReader* reader)
+{
+  const int   index     = reader->ReadInt();
+  position_             = reader->ReadVec2();
+  speed_                = reader->ReadFloat();
+  health_               = reader->ReadInt();
+  const float explosion = reader->ReadFloat();
+  explosions_           = reader->ReadInt();
+  const float knockback = reader->ReadFloat();
+  age_                  = reader->ReadFloat();
+
+  knockback_end_ = timers_->GetTime() + std::max(0.0f, knockback) / 5.0f;
+  timers_->Cancel(explosion_timer_);
+  explosion_timer_ = 0;
+  if(explosion >= 0.0f && health_ <= 0)
+  {
+    explosion_timer_ = timers_->Schedule(explosion, [this]() { Explode(); });
+  }
+
+  if(index < 0 || index > static_cast<int>(word_.length()))
+  {
+    reader->Fail();
+    return;
+  }
+
+  if(static_cast<unsigned int>(index) != index_)
+  {
+    const ScopedAllocationTag alloc_tag(AllocationScope::Text);
+    index_ = index;
+    ParsedText pt;
+    HighlightString(&pt, word_, 0, index_);
+    text_.SetText(pt);
+  }
+
+  sprite_.SetPosition(position_);
+  alpha_ = health_ <= 0
+               ? std::max(
+                     0.0f,
+                     1.0f - static_cast<float>(explosions_) / max_explosions)
+               : 1.0f;
+  sprite_.SetAlpha(alpha_);
+}
+
+void
+EnemyWord::AddSprite(CulledLayer* layer)
 {
   ASSERT(layer_ == nullptr);
   layer_ = layer;
-  layer_->Add(&sprite_);
+  layer_->Add(&sprite_, &alpha_);
 }
 
 void
@@ -106,9 +220,49 @@ EnemyWord::RemoveSprite()
 void
 EnemyWord::Render(SpriteRenderer* renderer)
 {
-  vec2f p = position_;
-  p.y -= sprite_.GetHeight();
-  text_.Draw(renderer, p, Color::White, Color::Blue);
+  text_.Draw(renderer, GetLabelPosition(), Color::White, Color::Blue);
+}
+
+void
+EnemyWord::RecordLabel(
+    std::vector<LabelCommand>*     labels,
+    std::vector<LabelWordCommand>* words,
+    int*                           next_label)
+{
+  if(label_ < 0)
+  {
+    label_ = (*next_label)++;
+  }
+  if(!label_recorded_)
+  {
+    words->push_back(LabelWordCommand{label_, word_});
+    label_recorded_ = true;
+  }
+  labels->push_back(LabelCommand{label_, index_, GetLabelPosition()});
+}
+
+void
+EnemyWord::SkipLabel()
+{
+  label_recorded_ = false;
+}
+
+bool
+EnemyWord::IsVisible(float screen_width, float screen_height) const
+{
+  // the label is drawn top centered just below the ship
+  const float half_width =
+      std::max(sprite_.GetWidth(), text_size_.GetWidth()) / 2.0f;
+  const float top = position_.y + sprite_.GetHeight() / 2.0f;
+  const float bottom =
+      position_.y - sprite_.GetHeight() - text_size_.GetHeight();
+  return IsInsideScreen(
+      position_.x - half_width,
+      position_.x + half_width,
+      bottom,
+      top,
+      screen_width,
+      screen_height);
 }
 
 void
@@ -141,17 +295,17 @@ HighlightString(
 }
 
 bool
-EnemyWord::Type(const std::string& input)
+EnemyWord::Type(char32_t input)
 {
   ASSERT(IsAlive());
-  const std::string& t = word_;
-  const char         c = t[index_];
-  const std::string  cstr(1, c);
-  const bool         is_same = cstr == input;
+  char32_t          expected = 0;
+  const std::size_t length   = DecodeUtf8(word_, index_, &expected);
+  const bool        is_same  = expected == input;
 
   if(is_same)
   {
-    index_ += 1;
+    const ScopedAllocationTag alloc_tag(AllocationScope::Text);
+    index_ += length;
     ParsedText pt;
     HighlightString(&pt, word_, 0, index_);
     text_.SetText(pt);
@@ -167,12 +321,30 @@ EnemyWord::IsAlive() const
   return index_ < t.length();
 }
 
+uint32_t
+EnemyWord::GetId() const
+{
+  return id_;
+}
+
 const std::string&
 EnemyWord::GetWord() const
 {
   return word_;
 }
 
+unsigned int
+EnemyWord::GetTypedCount() const
+{
+  return index_;
+}
+
+float
+EnemyWord::GetAge() const
+{
+  return age_;
+}
+
 const vec2f&
 EnemyWord::GetPosition() const
 {
@@ -185,18 +357,42 @@ EnemyWord::GetSize() const
   return Sizef::FromWidthHeight(sprite_.GetWidth(), sprite_.GetHeight());
 }
 
+vec2f
+EnemyWord::GetLabelPosition() const
+{
+  vec2f p = position_;
+  p.y -= sprite_.GetHeight();
+  return p;
+}
+
 void
-EnemyWord::Damage()
+EnemyWord::Damage(int amount)
 {
-  health_ -= 1;
+  const bool was_alive = health_ > 0;
+  health_ -= amount;
 
   if(health_ <= 0)
   {
     // speed_ = speed_ / 2.0f;
   }
 
-  knockback_ += 0.3f;
-  knockback_ = std::max(knockback_, 1.0f);
+  if(audio_ != nullptr)
+  {
+    audio_->Play(Sound::Hit);
+    if(was_alive && health_ <= 0)
+    {
+      audio_->Play(Sound::Explosion);
+    }
+  }
+
+  const float knockback = std::max(GetKnockback() + 0.3f, 1.0f);
+  knockback_end_        = timers_->GetTime() + knockback / 5.0f;
+
+  if(was_alive && health_ <= 0)
+  {
+    timers_->Cancel(explosion_timer_);
+    explosion_timer_ = timers_->Schedule(0.0f, [this]() { Explode(); });
+  }
 
   const float scale = 0.8f;
   for(int i = 0; i < 4; ++i)
@@ -1,7 +1,8 @@
 #ifndef SPACETYPER_ENEMYWORD_H
 #define SPACETYPER_ENEMYWORD_H
 
-#include <random>
+#include <cstdint>
+#include <vector>
 
 #include "render/sprite.h"
 #include "render/fonts.h"
@@ -9,63 +10,141 @@
 #include "core/vec2.h"
 #include "core/size.h"
 
-class TextureCache;
+#include "spacetyper/timerwheel.h"
+
+class AudioMixer;
+class GameAssets;
 class SpriteFader;
+class CulledLayer;
+class SnapshotReader;
+class SnapshotWriter;
+struct LabelCommand;
+struct LabelWordCommand;
+
+// style shared by all enemy labels
+void
+SetupEnemyLabel(Text* text);
+
+// the backgrounds are dropped at low quality
+void
+SetEnemyLabelBackground(Text* text, bool enabled);
+
+void
+HighlightString(
+    ParsedText* text, const std::string& str, int hi_start, int hi_end);
 
 class EnemyWord
 {
  public:
+  // the id stays the same for the life of the enemy, snapshots are keyed
+  // by it
   EnemyWord(
       SpriteFader*       fader,
-      TextureCache*      cache,
-      Font*              font,
+      TimerWheel*        timers,
+      const GameAssets*  assets,
+      uint32_t           id,
       const std::string& word);
   ~EnemyWord();
 
+  // may be null
+  void
+  SetAudio(AudioMixer* audio);
+
+  void
+  SetLabelBackground(bool enabled);
+
+  // placement is 0 to 1 across the room the enemy has along the top, the
+  // label is laid out by then so the enemy never sticks out of the screen
   void
-  Setup(std::mt19937* generator, float screen_width, float screen_height);
+  Setup(float placement, float speed, float screen_width, float screen_height);
 
   void
   Update(float delta);
 
+  // the word itself is not saved, it's required to create the enemy
+  void
+  Save(SnapshotWriter* writer) const;
+  void
+  Restore(SnapshotReader* reader);
+
   void
-  AddSprite(Layer* layer);
+  AddSprite(CulledLayer* layer);
   void
   RemoveSprite();
 
   void
   Render(SpriteRenderer* renderer);
 
+  // the word is recorded the first time and after a frame the label was
+  // skipped in, the render thread forgets labels that aren't drawn
+  void
+  RecordLabel(
+      std::vector<LabelCommand>*     labels,
+      std::vector<LabelWordCommand>* words,
+      int*                           next_label);
+  void
+  SkipLabel();
+
+  // true if either the ship or the label overlaps the screen
+  bool
+  IsVisible(float screen_width, float screen_height) const;
+
   bool
-  Type(const std::string& input);
+  Type(char32_t input);
   bool
   IsAlive() const;
 
+  uint32_t
+  GetId() const;
   const std::string&
   GetWord() const;
+  // in bytes, always at the start of a code point
+  unsigned int
+  GetTypedCount() const;
+  // seconds since the enemy was spawned
+  float
+  GetAge() const;
   const vec2f&
   GetPosition() const;
   const Sizef
   GetSize() const;
 
+  vec2f
+  GetLabelPosition() const;
+
   void
-  Damage();
+  Damage(int amount);
   bool
   IsDestroyed() const;
 
  private:
+  float
+  GetKnockback() const;
+
+  void
+  Explode();
+
   SpriteFader* fader_;
+  TimerWheel*  timers_;
+  AudioMixer*  audio_;
   Sprite       sprite_;
+  float        alpha_;
+  uint32_t     id_;
   std::string word_;
   Text         text_;
+  Sizef        text_size_;
   vec2f        position_;
-  Layer*       layer_;
+  CulledLayer* layer_;
   float        speed_;
   unsigned int index_;
   int          health_;
-  float        explisiontimer_;
+  TimerId      explosion_timer_;
   int          explosions_;
-  float        knockback_;
+  double       knockback_end_;
+  float        age_;
+  // -1 until the label is recorded the first time
+  int  label_;
+  bool label_recorded_;
 };
 
 #endif  // SPACETYPER_ENEMYWORD_H
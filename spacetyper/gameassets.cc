@@ -0,0 +1,31 @@
+#include "spacetyper/gameassets.h"
+
+#include "render/texturecache.h"
+
+GameAssets::GameAssets(TextureCache* cache, Font* font)
+    : font(font)
+    , small_star(cache->GetTexture("starSmall.png"))
+    , big_star(cache->GetTexture("starBig.png"))
+    , player(cache->GetTexture("player.png"))
+    , enemy(cache->GetTexture("enemyShip.png"))
+    , bullet(cache->GetTexture("laserBlue07.png"))
+{
+  // smoke effects
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_008.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_009.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_010.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_011.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_012.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_013.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_014.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_015.png"));
+  effects.push_back(cache->GetTexture("explosion/spaceEffects_016.png"));
+
+  // "laser"/explosion effects
+  effects.push_back(cache->GetTexture("explosion/laserBlue08.png"));
+  effects.push_back(cache->GetTexture("explosion/laserBlue10.png"));
+  effects.push_back(cache->GetTexture("explosion/laserGreen14.png"));
+  effects.push_back(cache->GetTexture("explosion/laserGreen16.png"));
+  effects.push_back(cache->GetTexture("explosion/laserRed08.png"));
+  effects.push_back(cache->GetTexture("explosion/laserRed10.png"));
+}
@@ -0,0 +1,29 @@
+#ifndef SPACETYPER_GAMEASSETS_H
+#define SPACETYPER_GAMEASSETS_H
+
+#include <memory>
+#include <vector>
+
+class TextureCache;
+class Texture2d;
+class Font;
+
+// Everything a game session needs from disk, loaded up front so sessions
+// never load anything and can share the assets between threads.
+class GameAssets
+{
+ public:
+  GameAssets(TextureCache* cache, Font* font);
+
+  typedef std::shared_ptr<Texture2d> TexturePtr;
+
+  Font*                   font;
+  TexturePtr              small_star;
+  TexturePtr              big_star;
+  TexturePtr              player;
+  TexturePtr              enemy;
+  TexturePtr              bullet;
+  std::vector<TexturePtr> effects;
+};
+
+#endif  // SPACETYPER_GAMEASSETS_H
@@ -0,0 +1,421 @@
+#include "spacetyper/gamesession.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "render/scalablesprite.h"
+#include "render/spriterender.h"
+
+#include "spacetyper/enemyword.h"
+#include "spacetyper/gameassets.h"
+#include "spacetyper/metrics.h"
+#include "spacetyper/qualitygovernor.h"
+#include "spacetyper/rendercommands.h"
+#include "spacetyper/snapshot.h"
+#include "spacetyper/telemetry.h"
+#include "spacetyper/textinput.h"
+
+namespace
+{
+  const float kRotationTime = 0.5f;
+  const float kScaleTime    = 0.6f;
+
+  // "STSN", bump the version when the layout changes
+  const int kSnapshotMagic   = 0x4E535453;
+  const int kSnapshotVersion = 8;
+
+  Sizef
+  GetTargetSize(EnemyWord* word, float scale)
+  {
+    const Sizef extra_size = Sizef::FromWidthHeight(40, 40);
+    return (word->GetSize() + extra_size) * scale;
+  }
+
+  // the telemetry stores a byte per character, so everything outside ascii
+  // is logged as '?', the same for what was typed and what was expected
+  char
+  GetTelemetryChar(char32_t c)
+  {
+    return c < 0x80 ? static_cast<char>(c) : '?';
+  }
+
+  // reports the time since the last stage, does nothing without metrics
+  class StageTimer
+  {
+   public:
+    explicit StageTimer(GameMetrics* metrics)
+        : metrics_(metrics)
+    {
+      if(metrics_ != nullptr)
+      {
+        last_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    void
+    Next(UpdateStage stage)
+    {
+      if(metrics_ == nullptr)
+      {
+        return;
+      }
+      const auto now = std::chrono::steady_clock::now();
+      metrics_->SetUpdateTime(
+          stage, std::chrono::duration<float>(now - last_).count());
+      last_ = now;
+    }
+
+   private:
+    GameMetrics*                          metrics_;
+    std::chrono::steady_clock::time_point last_;
+  };
+}
+
+GameSession::GameSession(
+    const GameAssets* assets,
+    const Dictionary* dictionary,
+    SpriteRenderer*   renderer,
+    int               width,
+    int               height,
+    unsigned int      seed)
+    : assets_(assets)
+    , generator_(seed)
+    , background_(renderer, width, height)
+    , objects_(renderer, width, height)
+    , foreground_(renderer, width, height)
+    , small_stars_(
+          25, width, height, assets->small_star, 20, &background_, generator_())
+    , big_stars_(
+          15, width, height, assets->big_star, 50, &background_, generator_())
+    , fader_(&foreground_, &timers_, generator_())
+    , player_(assets->player)
+    , ship_position_(width / 2, player_.GetHeight() / 2 + 10)
+    , bullets_(&objects_)
+    , enemies_(
+          &fader_,
+          &timers_,
+          assets,
+          &objects_,
+          dictionary,
+          width,
+          height,
+          &bullets_,
+          generator_())
+    , current_word_(nullptr)
+    , player_rotation_(Angle::Zero())
+    , target_scale_(1.0f)
+    , telemetry_(nullptr)
+    , metrics_(nullptr)
+{
+  for(const auto& texture : assets->effects)
+  {
+    fader_.RegisterTexture(texture);
+  }
+
+  objects_.Add(&player_);
+  player_.SetPosition(ship_position_);
+
+  enemies_.SpawnEnemies(5);
+}
+
+void
+GameSession::SetTelemetry(TelemetryWriter* telemetry)
+{
+  telemetry_ = telemetry;
+}
+
+void
+GameSession::SetAudio(AudioMixer* audio)
+{
+  enemies_.SetAudio(audio);
+}
+
+void
+GameSession::SetMetrics(GameMetrics* metrics)
+{
+  metrics_ = metrics;
+}
+
+void
+GameSession::SetQuality(const EffectsQuality& quality)
+{
+  fader_.SetQuality(quality);
+  small_stars_.SetDensity(quality.star_density);
+  big_stars_.SetDensity(quality.star_density);
+  enemies_.SetLabelBackgrounds(quality.label_backgrounds);
+}
+
+void
+GameSession::StartPrefetch()
+{
+  enemies_.StartPrefetch();
+}
+
+void
+GameSession::Type(const std::string& input)
+{
+  input_.Push(input);
+}
+
+bool
+GameSession::ProcessInput()
+{
+  // consecutive hits on the same word are fired as a single bullet and the
+  // ship turns once per batch no matter how many characters arrived
+  EnemyWord* fire_at    = nullptr;
+  int        damage     = 0;
+  Angle      rotation   = Angle::Zero();
+  bool       turn       = false;
+  bool       new_target = false;
+  const auto fire       = [&]() {
+    if(fire_at != nullptr)
+    {
+      rotation = enemies_.FireAt(ship_position_, fire_at, damage);
+      turn     = true;
+    }
+    fire_at = nullptr;
+    damage  = 0;
+  };
+
+  int      typed = 0;
+  char32_t c     = 0;
+  while(input_.Pop(&c))
+  {
+    typed += 1;
+    KeystrokeRecord record;
+    record.reaction = 0;
+    record.expected = 0;
+    record.typed    = GetTelemetryChar(c);
+    record.hit      = false;
+    record.word[0]  = 0;
+
+    if(current_word_ == nullptr)
+    {
+      current_word_ = enemies_.DetectWord(c);
+      if(current_word_ != nullptr)
+      {
+        record.expected = record.typed;
+        record.hit      = true;
+        new_target      = true;
+      }
+    }
+    else
+    {
+      char32_t expected = 0;
+      DecodeUtf8(
+          current_word_->GetWord(), current_word_->GetTypedCount(), &expected);
+      record.expected = GetTelemetryChar(expected);
+      record.hit      = current_word_->Type(c);
+    }
+
+    if(record.hit)
+    {
+      if(fire_at != current_word_)
+      {
+        fire();
+        fire_at = current_word_;
+      }
+      damage += 1;
+    }
+
+    if(telemetry_ != nullptr)
+    {
+      if(current_word_ != nullptr)
+      {
+        SetKeystrokeWord(&record, current_word_->GetWord());
+        record.reaction = current_word_->GetAge() * 1000.0f;
+      }
+      telemetry_->Record(record);
+    }
+
+    if(current_word_ != nullptr && current_word_->IsAlive() == false)
+    {
+      // the word keeps exploding so the bullets can still hit it
+      enemies_.Remove(current_word_);
+      current_word_ = nullptr;
+      turn          = true;
+    }
+  }
+  fire();
+
+  if(metrics_ != nullptr && typed > 0)
+  {
+    metrics_->AddTypedKeys(typed);
+  }
+
+  if(turn)
+  {
+    const Angle target_rotation =
+        current_word_ == nullptr ? Angle::Zero() : rotation;
+    player_rotation_.Clear().BackOut(target_rotation, kRotationTime);
+  }
+  if(new_target && current_word_ != nullptr)
+  {
+    target_scale_.SetValue(19.0f).Clear().CircOut(1.0f, kScaleTime);
+  }
+  return turn;
+}
+
+void
+GameSession::Update(float dt)
+{
+  StageTimer timer{metrics_};
+  ProcessInput();
+  timer.Next(UpdateStage::Input);
+  timers_.Advance(dt);
+  timer.Next(UpdateStage::Timers);
+  small_stars_.Update(dt);
+  big_stars_.Update(dt);
+  timer.Next(UpdateStage::Background);
+  enemies_.Update(dt);
+  timer.Next(UpdateStage::Enemies);
+  bullets_.Update(dt);
+  timer.Next(UpdateStage::Bullets);
+  fader_.Update(dt);
+  timer.Next(UpdateStage::Fader);
+  player_rotation_.Update(dt);
+  target_scale_.Update(dt);
+  player_.rotation = player_rotation_;
+
+  if(metrics_ != nullptr)
+  {
+    metrics_->SetCounts(
+        enemies_.EnemyCount(),
+        bullets_.GetCount(),
+        fader_.GetCount(),
+        background_.GetCount() + objects_.GetCount() + foreground_.GetCount());
+  }
+}
+
+void
+GameSession::LatchInput(float dt)
+{
+  if(ProcessInput())
+  {
+    player_rotation_.Update(dt);
+    player_.rotation = player_rotation_;
+  }
+}
+
+void
+GameSession::Render(SpriteRenderer* renderer, const ScalableSprite& target)
+{
+  background_.Render();
+  objects_.Render();
+  enemies_.Render(renderer);
+  foreground_.Render();
+
+  if(current_word_ != nullptr)
+  {
+    const Sizef size =
+        GetTargetSize(current_word_, target_scale_.GetValue());
+    renderer->DrawNinepatch(
+        target,
+        Rectf::FromPositionAnchorWidthAndHeight(
+            current_word_->GetPosition(),
+            vec2f{0.5f, 0.5f},
+            size.GetWidth(),
+            size.GetHeight()),
+        Rgba{Color::White});
+  }
+}
+
+void
+GameSession::Record(RenderCommandList* list)
+{
+  background_.Record(&list->background);
+  objects_.Record(&list->objects);
+  enemies_.Record(&list->labels, &list->label_words);
+  list->label_backgrounds = enemies_.HasLabelBackgrounds();
+  foreground_.Record(&list->foreground);
+
+  if(current_word_ != nullptr)
+  {
+    const Sizef size =
+        GetTargetSize(current_word_, target_scale_.GetValue());
+    list->has_target = true;
+    list->target     = NinepatchCommand{
+        current_word_->GetPosition(), size.GetWidth(), size.GetHeight()};
+  }
+}
+
+void
+GameSession::Save(std::vector<char>* snapshot, SnapshotMode mode) const
+{
+  SnapshotWriter writer{snapshot, mode};
+  writer.BeginRecord(SnapshotRecord::Session, 0);
+  writer.WriteInt(kSnapshotMagic);
+  writer.WriteInt(kSnapshotVersion);
+  writer.WriteInt(static_cast<int>(mode));
+  writer.WriteInt(
+      current_word_ != nullptr ? static_cast<int>(current_word_->GetId())
+                               : -1);
+  // running tweens are not saved, they are restored as finished
+  writer.WriteFloat(player_rotation_.GetValue().InRadians());
+  writer.WriteFloat(target_scale_.GetValue());
+  writer.EndRecord();
+
+  small_stars_.Save(&writer, 0);
+  big_stars_.Save(&writer, 1);
+  enemies_.Save(&writer);
+  bullets_.Save(&writer);
+  fader_.Save(&writer);
+}
+
+bool
+GameSession::Restore(const std::vector<char>& snapshot)
+{
+  SnapshotReader reader{snapshot};
+  reader.BeginRecord(SnapshotRecord::Session);
+  if(reader.ReadInt() != kSnapshotMagic ||
+     reader.ReadInt() != kSnapshotVersion)
+  {
+    return false;
+  }
+  const int mode = reader.ReadInt();
+  if(mode != static_cast<int>(SnapshotMode::Simulation) &&
+     mode != static_cast<int>(SnapshotMode::View))
+  {
+    return false;
+  }
+  reader.SetMode(static_cast<SnapshotMode>(mode));
+  const int   current  = reader.ReadInt();
+  const Angle rotation = Angle::FromRadians(reader.ReadFloat());
+  const float scale    = reader.ReadFloat();
+  reader.EndRecord();
+
+  small_stars_.Restore(&reader, 0);
+  big_stars_.Restore(&reader, 1);
+  enemies_.Restore(&reader);
+  bullets_.Restore(&reader, enemies_, assets_->bullet);
+  fader_.Restore(&reader);
+
+  current_word_ = current >= 0 ? enemies_.FindEnemy(current) : nullptr;
+  player_rotation_.Clear().SetValue(rotation);
+  target_scale_.Clear().SetValue(scale);
+  player_.rotation = rotation;
+
+  if(current >= 0 &&
+     (current_word_ == nullptr || current_word_->IsAlive() == false))
+  {
+    reader.Fail();
+  }
+  if(reader.IsOk() == false || reader.IsAtEnd() == false)
+  {
+    current_word_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+Enemies*
+GameSession::GetEnemies()
+{
+  return &enemies_;
+}
+
+EnemyWord*
+GameSession::GetCurrentWord()
+{
+  return current_word_;
+}
@@ -0,0 +1,137 @@
+#ifndef SPACETYPER_GAMESESSION_H
+#define SPACETYPER_GAMESESSION_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/angle.h"
+#include "core/interpolate.h"
+#include "core/vec2.h"
+#include "render/sprite.h"
+
+#include "spacetyper/background.h"
+#include "spacetyper/bulletlist.h"
+#include "spacetyper/culledlayer.h"
+#include "spacetyper/enemies.h"
+#include "spacetyper/snapshot.h"
+#include "spacetyper/spritefader.h"
+#include "spacetyper/textinput.h"
+#include "spacetyper/timerwheel.h"
+
+class AudioMixer;
+class Dictionary;
+class EnemyWord;
+class GameMetrics;
+class GameAssets;
+class ScalableSprite;
+class SpriteRenderer;
+struct EffectsQuality;
+struct RenderCommandList;
+class TelemetryWriter;
+
+// All the state of a single game. Sessions share nothing but the read-only
+// assets and dictionary so several can be updated on different threads.
+// The renderer may be null for sessions that are never rendered.
+class GameSession
+{
+ public:
+  GameSession(
+      const GameAssets* assets,
+      const Dictionary* dictionary,
+      SpriteRenderer*   renderer,
+      int               width,
+      int               height,
+      unsigned int      seed);
+
+  // records every typed character, may be null
+  void
+  SetTelemetry(TelemetryWriter* telemetry);
+
+  // plays the effects, may be null
+  void
+  SetAudio(AudioMixer* audio);
+
+  // times the update and counts what is alive, may be null
+  void
+  SetMetrics(GameMetrics* metrics);
+
+  void
+  SetQuality(const EffectsQuality& quality);
+
+  // creates the upcoming enemies on a worker thread so a wave doesn't cause
+  // a spike, the session plays out the same without it
+  void
+  StartPrefetch();
+
+  // text input from the player, any number of utf-8 characters that are
+  // applied on the next update
+  void
+  Type(const std::string& input);
+
+  void
+  Update(float dt);
+
+  // applies the text typed since the update to the frame that is about to be
+  // rendered, a turn that starts takes its first step of dt right away like
+  // it would have in the next update
+  void
+  LatchInput(float dt);
+
+  void
+  Render(SpriteRenderer* renderer, const ScalableSprite& target);
+
+  void
+  Record(RenderCommandList* list);
+
+  // a binary copy of the simulation, the assets are not included so it can
+  // only be restored into a session created with the same assets and size.
+  // A view snapshot can be shown but not simulated further
+  void
+  Save(std::vector<char>* snapshot, SnapshotMode mode) const;
+
+  // returns false if the snapshot is broken, the session is still safe to
+  // use but what it contains is undefined until a good snapshot is restored
+  bool
+  Restore(const std::vector<char>& snapshot);
+
+  Enemies*
+  GetEnemies();
+
+  EnemyWord*
+  GetCurrentWord();
+
+ private:
+  // returns true if the ship started a turn
+  bool
+  ProcessInput();
+
+  const GameAssets* assets_;
+  // only seeds the parts of the session, so it isn't saved
+  std::mt19937 generator_;
+
+  CulledLayer background_;
+  CulledLayer objects_;
+  CulledLayer foreground_;
+
+  // declared before everything that schedules timers so it outlives them
+  TimerWheel timers_;
+
+  Background  small_stars_;
+  Background  big_stars_;
+  SpriteFader fader_;
+  Sprite      player_;
+  vec2f       ship_position_;
+  BulletList  bullets_;
+  Enemies     enemies_;
+  EnemyWord*  current_word_;
+
+  Interpolate<Angle, AngleTransform> player_rotation_;
+  FloatInterpolate                   target_scale_;
+
+  TextInputQueue   input_;
+  TelemetryWriter* telemetry_;
+  GameMetrics*     metrics_;
+};
+
+#endif  // SPACETYPER_GAMESESSION_H
@@ -0,0 +1,62 @@
+#include "spacetyper/guiactivity.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+GuiActivity::GuiActivity(float settle_time)
+    : settle_time_(settle_time)
+    , time_left_(settle_time)
+    , mouse_(0.0f)
+    , mouse_down_(false)
+{
+}
+
+void
+GuiActivity::SetInput(const vec2f& mouse, bool mouse_down)
+{
+  const bool changed =
+      mouse.x != mouse_.x || mouse.y != mouse_.y || mouse_down != mouse_down_;
+  mouse_      = mouse;
+  mouse_down_ = mouse_down;
+  if(changed)
+  {
+    Invalidate();
+  }
+}
+
+void
+GuiActivity::Invalidate()
+{
+  time_left_ = settle_time_;
+}
+
+void
+GuiActivity::Update(float dt)
+{
+  time_left_ -= dt;
+}
+
+bool
+GuiActivity::IsIdle() const
+{
+  return time_left_ <= 0.0f;
+}
+
+float
+GetLongestInterpolation(const std::string& theme)
+{
+  const std::string key     = "\"interpolate_size_time\"";
+  float             longest = 0.0f;
+  for(std::size_t found = theme.find(key); found != std::string::npos;
+       found = theme.find(key, found + key.size()))
+  {
+    const std::size_t colon = theme.find(':', found + key.size());
+    if(colon == std::string::npos)
+    {
+      break;
+    }
+    const float time = std::strtof(theme.c_str() + colon + 1, nullptr);
+    longest          = std::max(longest, time);
+  }
+  return longest;
+}
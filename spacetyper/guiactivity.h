@@ -0,0 +1,41 @@
+#ifndef SPACETYPER_GUIACTIVITY_H
+#define SPACETYPER_GUIACTIVITY_H
+
+#include <string>
+
+#include "core/vec2.h"
+
+// Tracks if the gui needs to be stepped and rendered. The gui only changes
+// when the input changes and while the widgets interpolate after that, the
+// rest of the time the last presented frame can be kept as is.
+class GuiActivity
+{
+ public:
+  // settle_time needs to be longer than the longest widget interpolation
+  explicit GuiActivity(float settle_time);
+
+  void
+  SetInput(const vec2f& mouse, bool mouse_down);
+
+  // something outside of the gui changed, for example the window was exposed
+  void
+  Invalidate();
+
+  void
+  Update(float dt);
+
+  bool
+  IsIdle() const;
+
+ private:
+  float settle_time_;
+  float time_left_;
+  vec2f mouse_;
+  bool  mouse_down_;
+};
+
+// the longest interpolate_size_time in a gui theme json, 0 if there is none
+float
+GetLongestInterpolation(const std::string& theme);
+
+#endif  // SPACETYPER_GUIACTIVITY_H
@@ -0,0 +1,60 @@
+#include "spacetyper/inputlatency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#include "core/assert.h"
+
+void
+InputLatency::AddKey(double time)
+{
+  pending_.push_back(time);
+}
+
+void
+InputLatency::Present(double time)
+{
+  for(double key : pending_)
+  {
+    // the key time is converted from a coarser clock and may end up a bit
+    // in the future
+    samples_.push_back(static_cast<float>(std::max(0.0, time - key)));
+  }
+  pending_.clear();
+}
+
+int
+InputLatency::GetCount() const
+{
+  return samples_.size();
+}
+
+float
+InputLatency::GetPercentile(float fraction) const
+{
+  ASSERT(fraction >= 0.0f && fraction <= 1.0f);
+  if(samples_.empty())
+  {
+    return 0.0f;
+  }
+
+  // nearest rank, only called for reports so sorting a copy is fine
+  std::vector<float> sorted = samples_;
+  const std::size_t  rank =
+      static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+  const std::size_t index = rank == 0 ? 0 : rank - 1;
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+
+void
+InputLatency::Print(std::ostream* out) const
+{
+  ASSERT(out);
+  *out << "Input latency over " << GetCount() << " keys, p50 "
+       << GetPercentile(0.5f) * 1000.0f << "ms, p90 "
+       << GetPercentile(0.9f) * 1000.0f << "ms, p99 "
+       << GetPercentile(0.99f) * 1000.0f << "ms, max "
+       << GetPercentile(1.0f) * 1000.0f << "ms\n";
+}
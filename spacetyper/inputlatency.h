@@ -0,0 +1,36 @@
+#ifndef SPACETYPER_INPUTLATENCY_H
+#define SPACETYPER_INPUTLATENCY_H
+
+#include <iosfwd>
+#include <vector>
+
+// Time from a key press until the swap of the first frame that shows it.
+// Times are in seconds on any clock as long as the keys and the swaps use
+// the same one.
+class InputLatency
+{
+ public:
+  // a key that was given to the game
+  void
+  AddKey(double time);
+
+  // every key added so far was applied to the frame that was just swapped
+  void
+  Present(double time);
+
+  int
+  GetCount() const;
+
+  // seconds, fraction is 0 to 1, 0 when nothing has been presented
+  float
+  GetPercentile(float fraction) const;
+
+  void
+  Print(std::ostream* out) const;
+
+ private:
+  std::vector<double> pending_;
+  std::vector<float>  samples_;
+};
+
+#endif  // SPACETYPER_INPUTLATENCY_H
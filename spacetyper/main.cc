@@ -1,11 +1,17 @@
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
 
 #include "render/shader.h"
 #include "render/spriterender.h"
-#include "spacetyper/spritefader.h"
 
-#include "core/interpolate.h"
 #include "core/os.h"
 
 #include "core/filesystemimagegenerator.h"
@@ -19,17 +25,363 @@
 #include "render/shaderattribute2d.h"
 #include "render/texturecache.h"
 #include "render/viewport.h"
-#include "spacetyper/background.h"
-#include "spacetyper/bulletlist.h"
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/audio.h"
 #include "spacetyper/dictionary.h"
-#include "spacetyper/enemies.h"
-#include "spacetyper/enemyword.h"
+#include "spacetyper/gameassets.h"
+#include "spacetyper/gamesession.h"
+#include "spacetyper/guiactivity.h"
+#include "spacetyper/inputlatency.h"
+#include "spacetyper/metrics.h"
+#include "spacetyper/metricsserver.h"
+#include "spacetyper/nullrenderer.h"
+#include "spacetyper/perfhud.h"
+#include "spacetyper/programcache.h"
+#include "spacetyper/qualitygovernor.h"
+#include "spacetyper/rendercommands.h"
+#include "spacetyper/renderthread.h"
+#include "spacetyper/sessionhost.h"
+#include "spacetyper/spectator.h"
+#include "spacetyper/stresswaves.h"
+#include "spacetyper/telemetry.h"
 
 #include "gui/root.h"
 
+void
+RunHeadless(
+    const GameAssets* assets,
+    const Dictionary* dictionary,
+    int               width,
+    int               height,
+    int               session_count,
+    int               ticks)
+{
+  SessionHost host{assets,
+                   dictionary,
+                   width,
+                   height,
+                   session_count,
+                   std::random_device()(),
+                   0};
+  // a bit faster than 100 wpm
+  AutoTyper typer{session_count, 10.0f};
+
+  const float dt    = 1.0f / 60.0f;
+  const auto  start = std::chrono::steady_clock::now();
+  host.Run(ticks, dt, std::ref(typer));
+  const auto  end = std::chrono::steady_clock::now();
+  const float seconds =
+      std::chrono::duration<float>(end - start).count();
+
+  std::cout << session_count << " sessions, " << ticks << " ticks on "
+            << host.GetWorkerCount() << " workers in " << seconds << "s, "
+            << (session_count * ticks) / seconds << " session ticks/s\n";
+}
+
+// plays a bot driven session on the null renderer with a fixed seed so the
+// counts are comparable between runs, fails if a frame is over the budget
+int
+RunNullRender(
+    const GameAssets*  assets,
+    const Dictionary*  dictionary,
+    int                width,
+    int                height,
+    int                ticks,
+    const std::string& stats_path,
+    int                draw_call_budget)
+{
+  GameSession       game{assets, dictionary, nullptr, width, height, 0};
+  AutoTyper         typer{1, 10.0f};
+  RenderCommandList list;
+  NullRenderer      renderer;
+
+  const float dt = 1.0f / 60.0f;
+  for(int tick = 0; tick < ticks; ++tick)
+  {
+    typer(0, &game, dt);
+    game.Update(dt);
+    list.Clear();
+    game.Record(&list);
+    renderer.Draw(&list);
+  }
+
+  if(!stats_path.empty())
+  {
+    std::ofstream file(stats_path.c_str());
+    renderer.Dump(&file);
+  }
+
+  const RenderStats peak = renderer.GetPeak();
+  std::cout << renderer.GetFrameCount() << " frames, peak " << peak.draw_calls
+            << " draw calls, " << peak.state_changes << " state changes, "
+            << peak.texture_binds << " texture binds, " << peak.vertices
+            << " vertices, " << peak.bytes_uploaded << " bytes uploaded\n";
+
+  if(draw_call_budget > 0 && peak.draw_calls > draw_call_budget)
+  {
+    std::cerr << "Over the budget of " << draw_call_budget
+              << " draw calls per frame\n";
+    return -1;
+  }
+  return 0;
+}
+
+// the gui frames don't count and the stress mode measures at full quality
+void
+AdjustQuality(
+    QualityGovernor* governor,
+    GameSession*     game,
+    float            cost,
+    float            dt,
+    bool             fixed_quality)
+{
+  if(fixed_quality)
+  {
+    return;
+  }
+  if(governor->AddFrameTime(cost, dt))
+  {
+    game->SetQuality(governor->GetEffects());
+  }
+}
+
+// loads the linked program from the binary cache if the driver accepts it,
+// otherwise compiles it and caches the result. cache may be null
+void
+LoadShader(
+    Shader*            shader,
+    FileSystem*        file_system,
+    const std::string& path,
+    ProgramCache*      cache)
+{
+  if(cache == nullptr || !cache->IsEnabled())
+  {
+    shader->Load(file_system, path);
+    return;
+  }
+
+  // the prebound attributes are part of the program object so they survive
+  // both a rejected binary and the compile after it
+  std::vector<std::string> sources(3);
+  sources[0] = path;
+  const bool has_sources =
+      file_system->ReadFileToString(path + ".vert", &sources[1]) &&
+      file_system->ReadFileToString(path + ".frag", &sources[2]);
+  if(has_sources && cache->Load(shader->GetId(), sources))
+  {
+    return;
+  }
+
+  cache->PrepareLink(shader->GetId());
+  shader->Load(file_system, path);
+
+  std::string error;
+  if(has_sources && !cache->Store(shader->GetId(), sources, &error))
+  {
+    std::cerr << "Failed to cache " << path << ": " << error << "\n";
+  }
+}
+
+// seconds on the performance counter
+double
+GetSeconds(Uint64 counter)
+{
+  return static_cast<double>(counter) / SDL_GetPerformanceFrequency();
+}
+
+// events are stamped with SDL_GetTicks, moved to the performance counter
+double
+GetEventTime(Uint32 timestamp)
+{
+  const Uint32 age = SDL_GetTicks() - timestamp;
+  return GetSeconds(SDL_GetPerformanceCounter()) - age / 1000.0;
+}
+
+// takes the text input that arrived since the events were polled and applies
+// it to the frame about to be rendered, the other events are left for the
+// next frame. latency may be null
+void
+LatchTextInput(GameSession* game, InputLatency* latency, float dt)
+{
+  const int kBatch = 16;
+  SDL_Event events[kBatch];
+  SDL_PumpEvents();
+  for(;;)
+  {
+    const int count = SDL_PeepEvents(
+        events, kBatch, SDL_GETEVENT, SDL_TEXTINPUT, SDL_TEXTINPUT);
+    if(count <= 0)
+    {
+      break;
+    }
+    for(int i = 0; i < count; ++i)
+    {
+      game->Type(events[i].text.text);
+      if(latency != nullptr)
+      {
+        latency->AddKey(GetEventTime(events[i].text.timestamp));
+      }
+    }
+  }
+  game->LatchInput(dt);
+}
+
+// wavs in dist replace the synthesized effects
+void
+SetupSounds(AudioMixer* audio, int frequency)
+{
+  const std::pair<Sound, const char*> files[] = {
+      {Sound::Shot, "shot.wav"},
+      {Sound::Hit, "hit.wav"},
+      {Sound::Explosion, "explosion.wav"}};
+  for(const auto& file : files)
+  {
+    SoundBuffer buffer;
+    std::string error;
+    if(!LoadWav(file.second, frequency, &buffer, &error))
+    {
+      buffer = SynthesizeSound(file.first, frequency);
+    }
+    audio->SetSound(file.first, std::move(buffer));
+  }
+}
+
 int
 main(int argc, char** argv)
 {
+  bool        track_allocations = false;
+  std::string allocation_report;
+  std::string telemetry_path;
+  std::string dictionary_path;
+  std::string render_stats_path;
+  std::string metrics_path;
+  // not supported on osx where only the main thread may present
+  bool use_render_thread = false;
+  int  headless_sessions = 0;
+  int  headless_ticks    = 60 * 60;
+  bool null_render       = false;
+  int  draw_call_budget  = 0;
+  bool use_audio         = true;
+  // about 10ms, lower risks crackling on slow machines
+  int  audio_buffer     = 512;
+  bool use_shader_cache = true;
+  // tcp ports on the loopback interface
+  int spectator_server = 0;
+  int spectate         = 0;
+  // endless waves with the overlay, skips the menu
+  bool stress   = false;
+  bool show_hud = false;
+  // key press to swap, only without the render thread
+  bool measure_latency = false;
+  bool late_latch      = false;
+  for(int i = 1; i < argc; ++i)
+  {
+    const std::string arg              = argv[i];
+    const std::string report_prefix    = "--alloc-report=";
+    const std::string telemetry_prefix = "--telemetry=";
+    const std::string stats_prefix     = "--render-stats=";
+    const std::string metrics_prefix   = "--metrics=";
+    if(arg == "--alloc-report")
+    {
+      track_allocations = true;
+    }
+    else if(arg == "--render-thread")
+    {
+      use_render_thread = true;
+    }
+    else if(arg == "--headless" && i + 1 < argc)
+    {
+      headless_sessions = std::atoi(argv[++i]);
+    }
+    else if(arg == "--null-render")
+    {
+      null_render = true;
+    }
+    else if(arg == "--draw-call-budget" && i + 1 < argc)
+    {
+      draw_call_budget = std::atoi(argv[++i]);
+    }
+    else if(arg.compare(0, stats_prefix.size(), stats_prefix) == 0)
+    {
+      render_stats_path = arg.substr(stats_prefix.size());
+    }
+    else if(arg == "--ticks" && i + 1 < argc)
+    {
+      headless_ticks = std::atoi(argv[++i]);
+    }
+    else if(arg == "--no-audio")
+    {
+      use_audio = false;
+    }
+    else if(arg == "--audio-buffer" && i + 1 < argc)
+    {
+      audio_buffer = std::atoi(argv[++i]);
+    }
+    else if(arg == "--no-shader-cache")
+    {
+      use_shader_cache = false;
+    }
+    else if(arg == "--dictionary" && i + 1 < argc)
+    {
+      dictionary_path = argv[++i];
+    }
+    else if(arg == "--spectator-server" && i + 1 < argc)
+    {
+      spectator_server = std::atoi(argv[++i]);
+    }
+    else if(arg == "--spectate" && i + 1 < argc)
+    {
+      spectate = std::atoi(argv[++i]);
+    }
+    else if(arg == "--stress")
+    {
+      stress   = true;
+      show_hud = true;
+    }
+    else if(arg == "--hud")
+    {
+      show_hud = true;
+    }
+    else if(arg == "--input-latency")
+    {
+      measure_latency = true;
+    }
+    else if(arg == "--late-latch")
+    {
+      late_latch = true;
+    }
+    else if(arg == "--metrics")
+    {
+      metrics_path = "spacetyper-metrics.sock";
+    }
+    else if(arg.compare(0, metrics_prefix.size(), metrics_prefix) == 0)
+    {
+      metrics_path = arg.substr(metrics_prefix.size());
+    }
+    else if(arg == "--telemetry")
+    {
+      telemetry_path = "telemetry.sttl";
+    }
+    else if(arg.compare(0, telemetry_prefix.size(), telemetry_prefix) == 0)
+    {
+      telemetry_path = arg.substr(telemetry_prefix.size());
+    }
+    else if(arg.compare(0, report_prefix.size(), report_prefix) == 0)
+    {
+      track_allocations = true;
+      allocation_report = arg.substr(report_prefix.size());
+    }
+    else
+    {
+      std::cerr << "Unknown argument " << arg << "\n";
+    }
+  }
+
+  if(track_allocations)
+  {
+    SetupAllocationReport(allocation_report);
+  }
+
   if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_AUDIO) < 0)
   {
     std::cerr << "Failed to init SDL: " << SDL_GetError() << "\n";
@@ -65,7 +417,9 @@ main(int argc, char** argv)
       SDL_WINDOWPOS_UNDEFINED,
       width,
       height,
-      SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN);
+      SDL_WINDOW_OPENGL |
+          (headless_sessions > 0 || null_render ? SDL_WINDOW_HIDDEN
+                                                : SDL_WINDOW_SHOWN));
 
   if(window == NULL)
   {
@@ -73,7 +427,7 @@ main(int argc, char** argv)
     return -1;
   }
 
-  SDL_GL_CreateContext(window);
+  SDL_GLContext context = SDL_GL_CreateContext(window);
   Init init{SDL_GL_GetProcAddress, Init::BlendHack::EnableHack};
 
   if(init.ok == false)
@@ -91,10 +445,16 @@ main(int argc, char** argv)
   FileSystemImageGenerator::AddRoot(&file_system, "img-plain");
   FileSystemDefaultShaders::AddRoot(&file_system, "shaders");
 
+  std::unique_ptr<ProgramCache> program_cache;
+  if(use_shader_cache)
+  {
+    program_cache.reset(new ProgramCache(current_directory));
+  }
+
   TextureCache cache{&file_system};
   Shader       shader;
   attributes2d::PrebindShader(&shader);
-  shader.Load(&file_system, "shaders/sprite");
+  LoadShader(&shader, &file_system, "shaders/sprite", program_cache.get());
   FontCache font_cache{&file_system, &cache};
   auto      font = font_cache.GetFont("gamefont.json");
   // (cache.GetTexture("metalPanel_blueCorner.png"), 62, 14, 33, 14, vec2f(240,
@@ -103,42 +463,41 @@ main(int argc, char** argv)
       "crosshair.png", Sizef::FromWidthHeight(100, 100), &cache);
   SpriteRenderer renderer(&shader);
 
-  Dictionary dictionary;
-
-  Layer      background(&renderer);
-  Layer      objects(&renderer);
-  Layer      foreground(&renderer);
-  Background smallStars(
-      25, width, height, cache.GetTexture("starSmall.png"), 20, &background);
-  Background bigStars(
-      15, width, height, cache.GetTexture("starBig.png"), 50, &background);
-
-  SpriteFader fader(&foreground);
-
-  // smoke effects
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_008.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_009.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_010.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_011.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_012.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_013.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_014.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_015.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/spaceEffects_016.png"));
-
-  // "laser"/explosion effects
-  fader.RegisterTexture(cache.GetTexture("explosion/laserBlue08.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/laserBlue10.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/laserGreen14.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/laserGreen16.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/laserRed08.png"));
-  fader.RegisterTexture(cache.GetTexture("explosion/laserRed10.png"));
-
-  Sprite player(cache.GetTexture("player.png"));
-  objects.Add(&player);
-
-  vec2f shipPos(width / 2, player.GetHeight() / 2 + 10);
-  player.SetPosition(shipPos);
+  const Dictionary dictionary = dictionary_path.empty()
+                                    ? Dictionary()
+                                    : Dictionary(dictionary_path);
+  if(dictionary.IsEmpty())
+  {
+    // the wordlists print why they failed to load
+    std::cerr << "No words to create enemies from\n";
+    return -6;
+  }
+  GameAssets assets{&cache, font.get()};
+
+  if(headless_sessions > 0)
+  {
+    // the window is only needed for the context that loads the textures
+    RunHeadless(
+        &assets, &dictionary, width, height, headless_sessions, headless_ticks);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+  }
+
+  if(null_render)
+  {
+    const int result = RunNullRender(
+        &assets,
+        &dictionary,
+        width,
+        height,
+        headless_ticks,
+        render_stats_path,
+        draw_call_budget);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return result;
+  }
 
   const mat4f projection = init.GetOrthoProjection(width, height);
   Use(&shader);
@@ -149,9 +508,12 @@ main(int argc, char** argv)
       Recti::FromWidthHeight(width, height).SetBottomLeftToCopy(0, 0)};
   viewport.Activate();
 
-  Root       gui(Sizef::FromWidthHeight(width, height));
-  const bool gui_loaded =
-      gui.Load(&file_system, &font_cache, "gui.json", &cache);
+  Root gui(Sizef::FromWidthHeight(width, height));
+  bool gui_loaded = false;
+  {
+    const ScopedAllocationTag alloc_tag(AllocationScope::Gui);
+    gui_loaded = gui.Load(&file_system, &font_cache, "gui.json", &cache);
+  }
 
   if(gui_loaded == false)
   {
@@ -163,29 +525,123 @@ main(int argc, char** argv)
 
   SDL_StartTextInput();
 
-  BulletList bullets(&objects);
-  Enemies    enemies(
-      &fader,
-      &cache,
-      font.get(),
-      &objects,
-      &dictionary,
-      width,
-      height,
-      &bullets);
-  EnemyWord* current_word = nullptr;
+  GameSession game{
+      &assets, &dictionary, &renderer, width, height, std::random_device()()};
+  if(spectate == 0)
+  {
+    game.StartPrefetch();
+  }
 
-  enemies.SpawnEnemies(5);
+  TelemetryWriter telemetry;
+  if(!telemetry_path.empty())
+  {
+    std::string error;
+    if(telemetry.Start(telemetry_path, &error))
+    {
+      game.SetTelemetry(&telemetry);
+    }
+    else
+    {
+      std::cerr << error << "\n";
+    }
+  }
 
-  Interpolate<Angle, AngleTransform> player_rotation(Angle::Zero());
-  const float ROTATION_TIME = 0.5f;
-  const float SCALE_TIME    = 0.6f;
+  // the overlay shows the same counters as the metrics server
+  GameMetrics   metrics;
+  MetricsServer metrics_server{&metrics};
+  game.SetMetrics(&metrics);
+  if(!metrics_path.empty())
+  {
+    std::string error;
+    if(!metrics_server.Start(metrics_path, &error))
+    {
+      std::cerr << error << "\n";
+    }
+  }
 
-  FloatInterpolate target_scale(1.0f);
+  // F3 toggles the overlay
+  PerfHud     hud{&metrics, 60.0f};
+  OverlayText overlay_text{font.get()};
+  const vec2f overlay_position{10.0f, height - 10.0f};
+  float       render_time = 0.0f;
+  StressWaves stress_waves;
+  // the hud lines last handed to the overlay
+  int overlay_version = -1;
+
+  InputLatency  input_latency;
+  InputLatency* latency = nullptr;
+  if(measure_latency && use_render_thread)
+  {
+    std::cerr << "Input latency is not measured with the render thread\n";
+  }
+  else if(measure_latency)
+  {
+    latency = &input_latency;
+  }
 
-  bool gui_running = gui_loaded;
+  // a spectator only shows what the server sends, a server publishes every
+  // update
+  SpectatorServer   spectator_host;
+  SpectatorClient   spectator;
+  std::vector<char> spectator_snapshot;
+  if(spectate > 0)
+  {
+    std::string error;
+    if(!spectator.Connect(spectate, &error))
+    {
+      std::cerr << error << "\n";
+      return -5;
+    }
+  }
+  else if(spectator_server > 0)
+  {
+    std::string error;
+    if(!spectator_host.Start(spectator_server, &error))
+    {
+      std::cerr << error << "\n";
+      spectator_server = 0;
+    }
+  }
+
+  const int  audio_frequency = 48000;
+  AudioMixer audio;
+  if(use_audio)
+  {
+    SetupSounds(&audio, audio_frequency);
+    std::string error;
+    if(audio.Open(audio_frequency, audio_buffer, &error))
+    {
+      game.SetAudio(&audio);
+    }
+    else
+    {
+      std::cerr << error << "\n";
+    }
+  }
+
+  // F5 saves and F9 restores, starts as the beginning of the round
+  std::vector<char> checkpoint;
+  game.Save(&checkpoint, SnapshotMode::Simulation);
+
+  // spectators skip the menu and follow the server right away
+  bool gui_running = gui_loaded && spectate == 0 && !stress;
   bool running     = true;
 
+  // the gui keeps changing while the widgets interpolate in the theme
+  std::string gui_theme;
+  file_system.ReadFileToString("gui.json", &gui_theme);
+  GuiActivity gui_activity{GetLongestInterpolation(gui_theme)};
+
+  QualityGovernor governor{1.0f / 60.0f};
+
+  std::unique_ptr<RenderThread> render_thread;
+  if(use_render_thread)
+  {
+    render_thread.reset(new RenderThread(
+        window, context, &init, &renderer, &assets, &target, &gui));
+    render_thread->Start();
+  }
+
   int window_mouse_x = 0;
   int window_mouse_y = 0;
   SDL_GetMouseState(&window_mouse_x, &window_mouse_y);
@@ -193,17 +649,32 @@ main(int argc, char** argv)
 
   while(running)
   {
+    if(gui_running && gui_activity.IsIdle())
+    {
+      // nothing is changing, sleep until something happens and don't count
+      // the sleep as frame time
+      SDL_WaitEventTimeout(nullptr, 250);
+      NOW = SDL_GetPerformanceCounter();
+    }
+
     LAST           = NOW;
     NOW            = SDL_GetPerformanceCounter();
     const float dt = (NOW - LAST) * 1.0f / SDL_GetPerformanceFrequency();
     SDL_Event   e;
 
+    metrics.AddFrameTime(dt);
+    hud.AddFrame(dt, render_time);
+
     while(SDL_PollEvent(&e) != 0)
     {
       if(e.type == SDL_QUIT)
       {
         running = false;
       }
+      else if(e.type == SDL_WINDOWEVENT)
+      {
+        gui_activity.Invalidate();
+      }
       else if(e.type == SDL_MOUSEMOTION)
       {
         window_mouse_x = e.motion.x;
@@ -219,102 +690,214 @@ main(int argc, char** argv)
           mouse_lmb_down = down;
         }
       }
-      else if(e.type == SDL_TEXTINPUT)
+      else if(e.type == SDL_KEYDOWN && e.key.repeat == 0)
       {
-        const std::string& input = e.text.text;
-        if(gui_running)
+        if(e.key.keysym.sym == SDLK_F3)
+        {
+          show_hud = !show_hud;
+        }
+        else if(e.key.keysym.sym == SDLK_F5)
         {
+          game.Save(&checkpoint, SnapshotMode::Simulation);
         }
-        else
+        else if(e.key.keysym.sym == SDLK_F9 && !checkpoint.empty())
         {
-          if(current_word == nullptr)
+          if(game.Restore(checkpoint) == false)
           {
-            current_word = enemies.DetectWord(input);
-            if(current_word != nullptr)
-            {
-              const Angle target_rotation =
-                  enemies.FireAt(shipPos, current_word);
-              player_rotation.Clear().BackOut(target_rotation, ROTATION_TIME);
-              target_scale.SetValue(19.0f).Clear().CircOut(1.0f, SCALE_TIME);
-            }
+            std::cerr << "Failed to restore checkpoint\n";
           }
-          else
+        }
+      }
+      else if(e.type == SDL_TEXTINPUT)
+      {
+        const std::string& input = e.text.text;
+        if(gui_running == false && spectate == 0)
+        {
+          game.Type(input);
+          if(latency != nullptr)
           {
-            const bool hit = current_word->Type(input);
-            if(hit)
-            {
-              const Angle target_rotation =
-                  enemies.FireAt(shipPos, current_word);
-              player_rotation.Clear().BackOut(target_rotation, ROTATION_TIME);
-            }
-            if(current_word->IsAlive() == false)
-            {
-              enemies.Remove(current_word);
-              current_word               = nullptr;
-              const auto target_rotation = Angle::Zero();
-              player_rotation.Clear().BackOut(target_rotation, ROTATION_TIME);
-            }
+            latency->AddKey(GetEventTime(e.text.timestamp));
           }
         }
       }
     }
 
+    // Transform mouse position to the the euphoria coordinate system
+    const vec2f mouse_position{static_cast<float>(window_mouse_x),
+                               static_cast<float>(height - window_mouse_y)};
+
     if(gui_running)
     {
-      // Transform mouse position to the the euphoria coordinate system
-      const vec2f mouse_position{static_cast<float>(window_mouse_x),
-                                 static_cast<float>(height - window_mouse_y)};
-      gui.SetInputMouse(mouse_position, mouse_lmb_down);
-      gui.Step(dt);
+      const ScopedAllocationTag alloc_tag(AllocationScope::Gui);
+      gui_activity.SetInput(mouse_position, mouse_lmb_down);
+      if(gui_activity.IsIdle())
+      {
+        // the last presented frame is still valid, don't render or swap
+        if(track_allocations)
+        {
+          EndAllocationFrame();
+        }
+        continue;
+      }
+      if(render_thread == nullptr)
+      {
+        gui.SetInputMouse(mouse_position, mouse_lmb_down);
+        gui.Step(dt);
+      }
+      gui_activity.Update(dt);
+    }
+    else if(spectate > 0)
+    {
+      if(spectator.Poll(&spectator_snapshot) &&
+         game.Restore(spectator_snapshot) == false)
+      {
+        std::cerr << "Failed to restore the spectated session\n";
+      }
+      if(spectator.IsConnected() == false)
+      {
+        running = false;
+      }
     }
     else
     {
-      smallStars.Update(dt);
-      bigStars.Update(dt);
-      enemies.Update(dt);
-      bullets.Update(dt);
-      fader.Update(dt);
-      player_rotation.Update(dt);
-      target_scale.Update(dt);
-      player.rotation = player_rotation;
+      if(stress)
+      {
+        stress_waves.Update(&game, dt);
+        hud.SetWave(stress_waves.GetWave());
+      }
+      game.Update(dt);
+      // nobody to send it to, a client that connects gets a full snapshot
+      if(spectator_server > 0 && spectator_host.GetClientCount() > 0)
+      {
+        game.Save(&spectator_snapshot, SnapshotMode::View);
+        spectator_host.Publish(&spectator_snapshot);
+      }
     }
 
-    /*
-    // uncomment for infinite enemies!!
-    if(enemies.EnemyCount() == 0 ) {
-      enemies.SpawnEnemies(5);
+    // keys typed during the update are shown a frame earlier
+    if(late_latch && gui_running == false && spectate == 0)
+    {
+      LatchTextInput(&game, latency, dt);
+    }
+
+    // the lines are only laid out again after the hud rebuilt them
+    const bool overlay_changed =
+        show_hud && hud.GetVersion() != overlay_version;
+    if(overlay_changed)
+    {
+      overlay_version = hud.GetVersion();
+    }
+
+    const Uint64 render_start = SDL_GetPerformanceCounter();
+    if(render_thread != nullptr)
+    {
+      RenderCommandList* list = render_thread->BeginFrame();
+      // waiting for the render thread isn't work of this thread
+      const Uint64 record_start = SDL_GetPerformanceCounter();
+      game.Record(list);
+      list->gui_running = gui_running;
+      list->mouse       = mouse_position;
+      list->mouse_down  = mouse_lmb_down;
+      list->dt          = dt;
+      list->show_overlay     = show_hud;
+      list->overlay_position = overlay_position;
+      if(overlay_changed)
+      {
+        list->overlay         = hud.GetLines();
+        list->overlay_changed = true;
+      }
+      render_thread->Submit();
+      const float simulation_time = GetSeconds(render_start - NOW) +
+                                    GetSeconds(SDL_GetPerformanceCounter() -
+                                               record_start);
+      // the threads work on different frames at the same time, so a frame
+      // costs what the slower thread spends on it
+      render_time = render_thread->GetRenderTime();
+      AdjustQuality(
+          &governor,
+          &game,
+          std::max(simulation_time, render_time),
+          dt,
+          gui_running || stress);
     }
-    */
+    else
+    {
+      init.ClearScreen(Color::DarkslateGray);
 
-    init.ClearScreen(Color::DarkslateGray);
+      game.Render(&renderer, target);
 
-    background.Render();
-    objects.Render();
-    enemies.Render(&renderer);
-    foreground.Render();
+      if(gui_running)
+      {
+        const ScopedAllocationTag alloc_tag(AllocationScope::Gui);
+        gui.Render(&renderer);
+      }
 
-    if(current_word != nullptr)
+      if(overlay_changed)
+      {
+        overlay_text.SetLines(hud.GetLines());
+      }
+      if(show_hud)
+      {
+        overlay_text.Draw(&renderer, overlay_position);
+      }
+
+      // before the swap so waiting for vsync isn't counted
+      const Uint64 render_end = SDL_GetPerformanceCounter();
+      render_time             = GetSeconds(render_end - render_start);
+      AdjustQuality(
+          &governor,
+          &game,
+          GetSeconds(render_end - NOW),
+          dt,
+          gui_running || stress);
+      SDL_GL_SwapWindow(window);
+      // with vsync the swap returns when the frame is about to be shown
+      if(latency != nullptr)
+      {
+        latency->Present(GetSeconds(SDL_GetPerformanceCounter()));
+      }
+    }
+
+    if(track_allocations)
     {
-      const Sizef extra_size     = Sizef::FromWidthHeight(40, 40);
-      const Sizef size           = current_word->GetSize();
-      const Sizef size_and_extra = size + extra_size;
-      const Sizef scaled_size    = size_and_extra * target_scale.GetValue();
-      renderer.DrawNinepatch(
-          target,
-          Rectf::FromPositionAnchorWidthAndHeight(
-              current_word->GetPosition(),
-              vec2f{0.5f, 0.5f},
-              scaled_size.GetWidth(),
-              scaled_size.GetHeight()),
-          Rgba{Color::White});
+      EndAllocationFrame();
     }
+  }
 
-    if(gui_running)
+  if(render_thread != nullptr)
+  {
+    render_thread->Stop();
+  }
+
+  if(track_allocations)
+  {
+    PrintAllocationSummary();
+  }
+
+  if(latency != nullptr)
+  {
+    latency->Print(&std::cout);
+  }
+
+  if(stress)
+  {
+    std::string drop;
+    if(hud.GetFirstDrop(&drop))
     {
-      gui.Render(&renderer);
+      std::cout << "First second below 60 fps: " << drop << "\n";
     }
+    else
+    {
+      std::cout << "Kept 60 fps up to wave " << stress_waves.GetWave() << "\n";
+    }
+  }
 
-    SDL_GL_SwapWindow(window);
+  audio.Close();
+  telemetry.Stop();
+  if(telemetry.GetDropped() > 0)
+  {
+    std::cerr << "Telemetry dropped " << telemetry.GetDropped()
+              << " keystrokes\n";
   }
 
   SDL_DestroyWindow(window);
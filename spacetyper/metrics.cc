@@ -0,0 +1,227 @@
+#include "spacetyper/metrics.h"
+
+#include <limits>
+#include <sstream>
+
+#include "core/assert.h"
+
+#include "spacetyper/alloctracker.h"
+
+namespace
+{
+  const int kStageCount = static_cast<int>(UpdateStage::Count);
+
+  const char* const kStageNames[kStageCount] = {
+      "input", "timers", "background", "enemies", "bullets", "fader"};
+
+  // seconds, the last bucket catches everything
+  const float kFrameBounds[] = {
+      0.004f, 0.008f, 0.012f, 1.0f / 60.0f, 0.020f, 1.0f / 30.0f, 0.050f, 0.1f};
+
+  // the only writer is the game thread so a load and a store is enough and
+  // cheaper than a locked add
+  template <typename T, typename V>
+  void
+  Add(std::atomic<T>* value, V amount)
+  {
+    value->store(
+        value->load(std::memory_order_relaxed) + amount,
+        std::memory_order_relaxed);
+  }
+
+  template <typename T>
+  T
+  Get(const std::atomic<T>& value)
+  {
+    return value.load(std::memory_order_relaxed);
+  }
+
+  void
+  WriteGauge(
+      std::ostringstream* out, const char* name, const char* help, double v)
+  {
+    *out << "# HELP " << name << " " << help << "\n";
+    *out << "# TYPE " << name << " gauge\n";
+    *out << name << " " << v << "\n";
+  }
+}
+
+const char*
+UpdateStageName(UpdateStage stage)
+{
+  const int index = static_cast<int>(stage);
+  if(index < 0 || index >= kStageCount)
+  {
+    return "unknown";
+  }
+  return kStageNames[index];
+}
+
+GameMetrics::GameMetrics()
+    : frame_count_(0)
+    , frame_sum_(0.0)
+    , enemies_(0)
+    , bullets_(0)
+    , particles_(0)
+    , sprites_(0)
+    , keys_typed_(0)
+    , keys_per_second_(0.0f)
+    , window_time_(0.0f)
+    , window_keys_(0)
+{
+  static_assert(
+      sizeof(kFrameBounds) / sizeof(kFrameBounds[0]) + 1 == kFrameBuckets,
+      "one bucket per bound and one for the rest");
+  for(auto& bucket : frame_buckets_)
+  {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  for(auto& time : update_times_)
+  {
+    time.store(0.0f, std::memory_order_relaxed);
+  }
+}
+
+void
+GameMetrics::AddFrameTime(float seconds)
+{
+  int bucket = 0;
+  while(bucket < kFrameBuckets - 1 && seconds > kFrameBounds[bucket])
+  {
+    ++bucket;
+  }
+  Add(&frame_buckets_[bucket], 1);
+  Add(&frame_count_, 1);
+  Add(&frame_sum_, seconds);
+
+  window_time_ += seconds;
+  if(window_time_ >= 1.0f)
+  {
+    keys_per_second_.store(
+        window_keys_ / window_time_, std::memory_order_relaxed);
+    window_time_ = 0.0f;
+    window_keys_ = 0;
+  }
+}
+
+void
+GameMetrics::SetUpdateTime(UpdateStage stage, float seconds)
+{
+  const int index = static_cast<int>(stage);
+  ASSERT(index >= 0 && index < kStageCount);
+  update_times_[index].store(seconds, std::memory_order_relaxed);
+}
+
+void
+GameMetrics::SetCounts(int enemies, int bullets, int particles, int sprites)
+{
+  enemies_.store(enemies, std::memory_order_relaxed);
+  bullets_.store(bullets, std::memory_order_relaxed);
+  particles_.store(particles, std::memory_order_relaxed);
+  sprites_.store(sprites, std::memory_order_relaxed);
+}
+
+void
+GameMetrics::AddTypedKeys(int count)
+{
+  Add(&keys_typed_, count);
+  window_keys_ += count;
+}
+
+float
+GameMetrics::GetUpdateTime(UpdateStage stage) const
+{
+  const int index = static_cast<int>(stage);
+  ASSERT(index >= 0 && index < kStageCount);
+  return Get(update_times_[index]);
+}
+
+int
+GameMetrics::GetEnemyCount() const
+{
+  return Get(enemies_);
+}
+
+int
+GameMetrics::GetBulletCount() const
+{
+  return Get(bullets_);
+}
+
+int
+GameMetrics::GetParticleCount() const
+{
+  return Get(particles_);
+}
+
+int
+GameMetrics::GetSpriteCount() const
+{
+  return Get(sprites_);
+}
+
+void
+GameMetrics::WriteText(std::string* text) const
+{
+  ASSERT(text);
+  std::ostringstream out;
+  out.precision(std::numeric_limits<float>::digits10);
+
+  out << "# HELP spacetyper_frame_seconds Time between frames.\n";
+  out << "# TYPE spacetyper_frame_seconds histogram\n";
+  uint64_t cumulative = 0;
+  for(int i = 0; i < kFrameBuckets; ++i)
+  {
+    cumulative += Get(frame_buckets_[i]);
+    out << "spacetyper_frame_seconds_bucket{le=\"";
+    if(i < kFrameBuckets - 1)
+    {
+      out << kFrameBounds[i];
+    }
+    else
+    {
+      out << "+Inf";
+    }
+    out << "\"} " << cumulative << "\n";
+  }
+  out << "spacetyper_frame_seconds_sum " << Get(frame_sum_) << "\n";
+  out << "spacetyper_frame_seconds_count " << Get(frame_count_) << "\n";
+
+  out << "# HELP spacetyper_update_seconds Time spent in the last update.\n";
+  out << "# TYPE spacetyper_update_seconds gauge\n";
+  for(int i = 0; i < kStageCount; ++i)
+  {
+    out << "spacetyper_update_seconds{stage=\"" << kStageNames[i] << "\"} "
+        << Get(update_times_[i]) << "\n";
+  }
+
+  WriteGauge(&out, "spacetyper_enemies", "Enemies alive.", Get(enemies_));
+  WriteGauge(&out, "spacetyper_bullets", "Bullets in flight.", Get(bullets_));
+  WriteGauge(
+      &out, "spacetyper_particles", "Explosion particles.", Get(particles_));
+  WriteGauge(
+      &out,
+      "spacetyper_layer_sprites",
+      "Sprites in all layers.",
+      Get(sprites_));
+
+  out << "# HELP spacetyper_keys_typed_total Characters typed.\n";
+  out << "# TYPE spacetyper_keys_typed_total counter\n";
+  out << "spacetyper_keys_typed_total " << Get(keys_typed_) << "\n";
+  WriteGauge(
+      &out,
+      "spacetyper_keys_per_second",
+      "Characters typed over the last second.",
+      Get(keys_per_second_));
+
+  std::size_t live = 0;
+  std::size_t peak = 0;
+  if(GetHeapUsage(&live, &peak))
+  {
+    WriteGauge(&out, "spacetyper_heap_bytes", "Bytes allocated.", live);
+    WriteGauge(
+        &out, "spacetyper_heap_peak_bytes", "Most bytes allocated.", peak);
+  }
+
+  *text = out.str();
+}
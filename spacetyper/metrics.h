@@ -0,0 +1,81 @@
+#ifndef SPACETYPER_METRICS_H
+#define SPACETYPER_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum class UpdateStage
+{
+  Input,
+  Timers,
+  Background,
+  Enemies,
+  Bullets,
+  Fader,
+  Count
+};
+
+const char*
+UpdateStageName(UpdateStage stage);
+
+// Health counters of a running game. Every counter has a single writer, the
+// game thread, which only does relaxed atomic stores so a reader on another
+// thread never blocks a frame, the reader may see a frame half updated.
+class GameMetrics
+{
+ public:
+  GameMetrics();
+
+  // game thread
+  void
+  AddFrameTime(float seconds);
+
+  void
+  SetUpdateTime(UpdateStage stage, float seconds);
+
+  void
+  SetCounts(int enemies, int bullets, int particles, int sprites);
+
+  void
+  AddTypedKeys(int count);
+
+  // any thread, prometheus text exposition format
+  void
+  WriteText(std::string* text) const;
+
+  // any thread
+  float
+  GetUpdateTime(UpdateStage stage) const;
+  int
+  GetEnemyCount() const;
+  int
+  GetBulletCount() const;
+  int
+  GetParticleCount() const;
+  int
+  GetSpriteCount() const;
+
+ private:
+  static const int kFrameBuckets = 9;
+
+  std::atomic<uint64_t> frame_buckets_[kFrameBuckets];
+  std::atomic<uint64_t> frame_count_;
+  std::atomic<double>   frame_sum_;
+
+  std::atomic<float> update_times_[static_cast<int>(UpdateStage::Count)];
+
+  std::atomic<int> enemies_;
+  std::atomic<int> bullets_;
+  std::atomic<int> particles_;
+  std::atomic<int> sprites_;
+
+  std::atomic<uint64_t> keys_typed_;
+  std::atomic<float>    keys_per_second_;
+
+  // game thread only, the keys typed in the current one second window
+  float window_time_;
+  int   window_keys_;
+};
+
+#endif  // SPACETYPER_METRICS_H
@@ -0,0 +1,193 @@
+#include "spacetyper/metricsserver.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "core/assert.h"
+
+#include "spacetyper/metrics.h"
+
+namespace
+{
+  // how often the thread checks if it should stop
+  const int kPollTimeout = 100;
+
+  // scrapers send a request first, raw clients may not send anything
+  const int kRequestTimeout = 100;
+}
+
+MetricsServer::MetricsServer(const GameMetrics* metrics)
+    : metrics_(metrics)
+    , socket_(-1)
+    , running_(false)
+    , requests_(0)
+{
+  ASSERT(metrics);
+}
+
+MetricsServer::~MetricsServer()
+{
+  Stop();
+}
+
+int
+MetricsServer::GetRequestCount() const
+{
+  return requests_.load(std::memory_order_relaxed);
+}
+
+#ifdef _WIN32
+
+bool
+MetricsServer::Start(const std::string&, std::string* error)
+{
+  *error = "The metrics server needs unix domain sockets";
+  return false;
+}
+
+void
+MetricsServer::Stop()
+{
+}
+
+void
+MetricsServer::Run()
+{
+}
+
+void
+MetricsServer::Serve(int)
+{
+}
+
+#else
+
+bool
+MetricsServer::Start(const std::string& path, std::string* error)
+{
+  ASSERT(error);
+  ASSERT(socket_ == -1);
+
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(path.empty() || path.length() >= sizeof(address.sun_path))
+  {
+    *error = "Invalid metrics socket path " + path;
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.length() + 1);
+
+  socket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(socket_ == -1)
+  {
+    *error = std::string{"Failed to create metrics socket: "} +
+             std::strerror(errno);
+    return false;
+  }
+
+  // left behind if the game crashed
+  unlink(path.c_str());
+  if(bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+         0 ||
+     listen(socket_, 4) != 0)
+  {
+    *error = "Failed to listen on " + path + ": " + std::strerror(errno);
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  path_    = path;
+  running_ = true;
+  thread_  = std::thread{&MetricsServer::Run, this};
+  return true;
+}
+
+void
+MetricsServer::Stop()
+{
+  if(thread_.joinable())
+  {
+    running_ = false;
+    thread_.join();
+  }
+  if(socket_ != -1)
+  {
+    close(socket_);
+    socket_ = -1;
+    unlink(path_.c_str());
+  }
+}
+
+void
+MetricsServer::Run()
+{
+  while(running_)
+  {
+    pollfd listener{socket_, POLLIN, 0};
+    if(poll(&listener, 1, kPollTimeout) <= 0)
+    {
+      continue;
+    }
+
+    const int client = accept(socket_, nullptr, nullptr);
+    if(client != -1)
+    {
+      Serve(client);
+      close(client);
+    }
+  }
+}
+
+void
+MetricsServer::Serve(int client)
+{
+  // the request itself doesn't matter, read it so closing doesn't reset
+  // the connection before the client has read the response
+  pollfd request{client, POLLIN, 0};
+  if(poll(&request, 1, kRequestTimeout) > 0)
+  {
+    char buffer[1024];
+    recv(client, buffer, sizeof(buffer), 0);
+  }
+
+  std::string body;
+  metrics_->WriteText(&body);
+  const std::string response =
+      "HTTP/1.0 200 OK\r\n"
+      "Content-Type: text/plain; version=0.0.4\r\n"
+      "Content-Length: " +
+      std::to_string(body.size()) + "\r\n\r\n" + body;
+
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  // osx has SO_NOSIGPIPE instead
+  const int value = 1;
+  setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+  const int flags = 0;
+#endif
+
+  size_t sent = 0;
+  while(sent < response.size())
+  {
+    const ssize_t result = send(
+        client, response.data() + sent, response.size() - sent, flags);
+    if(result <= 0)
+    {
+      return;
+    }
+    sent += result;
+  }
+  requests_.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SPACETYPER_METRICSSERVER_H
+#define SPACETYPER_METRICSSERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+class GameMetrics;
+
+// Serves the metrics on a unix domain socket from a thread of its own, every
+// connection gets a http response with the current snapshot, so
+//   curl --unix-socket spacetyper-metrics.sock http://localhost/metrics
+// works as well as a plain socat. Not available on windows.
+class MetricsServer
+{
+ public:
+  explicit MetricsServer(const GameMetrics* metrics);
+  ~MetricsServer();
+
+  // removes a stale socket file at path
+  bool
+  Start(const std::string& path, std::string* error);
+
+  // closes the socket and removes the file
+  void
+  Stop();
+
+  int
+  GetRequestCount() const;
+
+ private:
+  void
+  Run();
+
+  void
+  Serve(int client);
+
+  const GameMetrics* metrics_;
+  std::string        path_;
+  int                socket_;
+  std::atomic<bool>  running_;
+  std::atomic<int>   requests_;
+  std::thread        thread_;
+};
+
+#endif  // SPACETYPER_METRICSSERVER_H
@@ -0,0 +1,197 @@
+#include "spacetyper/nullrenderer.h"
+
+#include <algorithm>
+#include <ostream>
+
+#include "core/assert.h"
+
+#include "spacetyper/rendercommands.h"
+#include "spacetyper/textinput.h"
+
+namespace
+{
+  // model matrix, tint and texture region
+  const size_t kQuadUniformBytes = 16 * 4 + 4 * 4 + 4 * 4;
+  const int    kQuadVertices     = 6;
+  // the nine patch has no texture region but uploads the vertices, 2d
+  // position and uv
+  const size_t kNinepatchUniformBytes = 16 * 4 + 4 * 4;
+  const int    kNinepatchVertices     = 9 * kQuadVertices;
+  const size_t kVertexBytes           = 4 * 4;
+
+  // the textures the labels are drawn with aren't part of the command list
+  const char kFontTexture  = 0;
+  const char kWhiteTexture = 0;
+  const char kNinepatch    = 0;
+}
+
+RenderStats::RenderStats()
+    : draw_calls(0)
+    , state_changes(0)
+    , texture_binds(0)
+    , vertices(0)
+    , bytes_uploaded(0)
+{
+}
+
+NullRenderer::NullRenderer()
+    : current_(nullptr)
+    , texture_(nullptr)
+    , tint_(Tint::None)
+    , ninepatch_(false)
+    , frame_(0)
+{
+}
+
+void
+NullRenderer::Draw(RenderCommandList* list)
+{
+  ASSERT(list);
+  frames_.emplace_back();
+  current_ = &frames_.back();
+
+  // gl state carries over between frames
+  for(auto* sprites : {&list->background, &list->objects})
+  {
+    for(const SpriteCommand& sprite : *sprites)
+    {
+      DrawQuad(sprite.texture, Tint::White);
+    }
+  }
+
+  // the words are kept like the render thread keeps its labels
+  for(const LabelWordCommand& word : list->label_words)
+  {
+    labels_[word.label] = Label{word.word, frame_};
+  }
+  for(const LabelCommand& command : list->labels)
+  {
+    const auto found = labels_.find(command.label);
+    ASSERT(found != labels_.end());
+    found->second.frame = frame_;
+    DrawLabel(found->second.word, command.typed, list->label_backgrounds);
+  }
+  for(auto it = labels_.begin(); it != labels_.end();)
+  {
+    if(it->second.frame != frame_)
+    {
+      it = labels_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  frame_ += 1;
+
+  for(const SpriteCommand& sprite : list->foreground)
+  {
+    DrawQuad(sprite.texture, Tint::White);
+  }
+
+  if(list->has_target)
+  {
+    DrawNinepatch(&kNinepatch);
+  }
+
+  current_ = nullptr;
+}
+
+int
+NullRenderer::GetFrameCount() const
+{
+  return static_cast<int>(frames_.size());
+}
+
+const RenderStats&
+NullRenderer::GetFrame(int frame) const
+{
+  ASSERT(frame >= 0 && frame < GetFrameCount());
+  return frames_[frame];
+}
+
+RenderStats
+NullRenderer::GetPeak() const
+{
+  RenderStats peak;
+  for(const RenderStats& frame : frames_)
+  {
+    peak.draw_calls     = std::max(peak.draw_calls, frame.draw_calls);
+    peak.state_changes  = std::max(peak.state_changes, frame.state_changes);
+    peak.texture_binds  = std::max(peak.texture_binds, frame.texture_binds);
+    peak.vertices       = std::max(peak.vertices, frame.vertices);
+    peak.bytes_uploaded = std::max(peak.bytes_uploaded, frame.bytes_uploaded);
+  }
+  return peak;
+}
+
+void
+NullRenderer::Dump(std::ostream* out) const
+{
+  ASSERT(out);
+  for(int i = 0; i < GetFrameCount(); ++i)
+  {
+    const RenderStats& frame = frames_[i];
+    *out << i << " " << frame.draw_calls << " " << frame.state_changes << " "
+         << frame.texture_binds << " " << frame.vertices << " "
+         << frame.bytes_uploaded << "\n";
+  }
+}
+
+void
+NullRenderer::DrawQuad(const void* texture, Tint tint)
+{
+  SetState(texture, tint, false);
+  current_->draw_calls += 1;
+  current_->vertices += kQuadVertices;
+  current_->bytes_uploaded += kQuadUniformBytes;
+}
+
+void
+NullRenderer::DrawNinepatch(const void* texture)
+{
+  SetState(texture, Tint::White, true);
+  current_->draw_calls += 1;
+  current_->vertices += kNinepatchVertices;
+  current_->bytes_uploaded +=
+      kNinepatchUniformBytes + kNinepatchVertices * kVertexBytes;
+}
+
+void
+NullRenderer::SetState(const void* texture, Tint tint, bool ninepatch)
+{
+  if(texture != texture_)
+  {
+    texture_ = texture;
+    current_->texture_binds += 1;
+  }
+  if(tint != tint_)
+  {
+    tint_ = tint;
+    current_->state_changes += 1;
+  }
+  if(ninepatch != ninepatch_)
+  {
+    ninepatch_ = ninepatch;
+    current_->state_changes += 1;
+  }
+}
+
+void
+NullRenderer::DrawLabel(
+    const std::string& word, unsigned int typed, bool background)
+{
+  if(background)
+  {
+    DrawQuad(&kWhiteTexture, Tint::Background);
+  }
+
+  size_t pos = 0;
+  while(pos < word.length())
+  {
+    const Tint tint = pos < typed ? Tint::Highlight : Tint::White;
+    char32_t   c    = 0;
+    pos += std::max<size_t>(1, DecodeUtf8(word, pos, &c));
+    DrawQuad(&kFontTexture, tint);
+  }
+}
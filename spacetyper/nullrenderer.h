@@ -0,0 +1,90 @@
+#ifndef SPACETYPER_NULLRENDERER_H
+#define SPACETYPER_NULLRENDERER_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct RenderCommandList;
+
+struct RenderStats
+{
+  RenderStats();
+
+  int    draw_calls;
+  // tint and vertex array switches, texture binds are counted apart
+  int    state_changes;
+  int    texture_binds;
+  int    vertices;
+  size_t bytes_uploaded;
+};
+
+// Render backend that draws nothing and counts what the gl renderer would
+// issue for a recorded frame instead, so render cost can be measured and
+// budgeted on machines without a gpu. The counts follow how euphoria draws:
+// every sprite, glyph and label background is a quad from the shared vertex
+// array with its own draw call and uniform upload, a nine patch uploads its
+// 9 quads to a buffer of its own and draws them in one call.
+class NullRenderer
+{
+ public:
+  NullRenderer();
+
+  void
+  Draw(RenderCommandList* list);
+
+  int
+  GetFrameCount() const;
+
+  const RenderStats&
+  GetFrame(int frame) const;
+
+  // the highest value of every counter over all frames
+  RenderStats
+  GetPeak() const;
+
+  // one line per frame: frame draw_calls state_changes texture_binds
+  // vertices bytes_uploaded
+  void
+  Dump(std::ostream* out) const;
+
+ private:
+  enum class Tint
+  {
+    None,
+    White,
+    Highlight,
+    Background
+  };
+
+  void
+  DrawQuad(const void* texture, Tint tint);
+
+  void
+  DrawNinepatch(const void* texture);
+
+  void
+  SetState(const void* texture, Tint tint, bool ninepatch);
+
+  void
+  DrawLabel(const std::string& word, unsigned int typed, bool background);
+
+  struct Label
+  {
+    std::string word;
+    int         frame;
+  };
+
+  std::vector<RenderStats> frames_;
+  RenderStats*             current_;
+  const void*              texture_;
+  Tint                     tint_;
+  bool                     ninepatch_;
+
+  std::unordered_map<int, Label> labels_;
+  int                            frame_;
+};
+
+#endif  // SPACETYPER_NULLRENDERER_H
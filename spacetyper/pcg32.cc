@@ -0,0 +1,28 @@
+#include "spacetyper/pcg32.h"
+
+namespace
+{
+  const uint64_t kMultiplier = 6364136223846793005ull;
+  // the sequence of the reference implementation's examples
+  const uint64_t kSequence = 54;
+}
+
+Pcg32::Pcg32(uint64_t seed)
+    : state(0)
+    , increment((kSequence << 1u) | 1u)
+{
+  (*this)();
+  state += seed;
+  (*this)();
+}
+
+Pcg32::result_type
+Pcg32::operator()()
+{
+  const uint64_t old = state;
+  state              = old * kMultiplier + increment;
+  const uint32_t xorshifted =
+      static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+  const uint32_t rotation = static_cast<uint32_t>(old >> 59u);
+  return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31u));
+}
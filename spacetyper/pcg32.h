@@ -0,0 +1,35 @@
+#ifndef SPACETYPER_PCG32_H
+#define SPACETYPER_PCG32_H
+
+#include <cstdint>
+
+// The pcg32 generator, works with the std distributions like std::mt19937
+// but the whole state is two integers so snapshots can store it as is.
+class Pcg32
+{
+ public:
+  typedef uint32_t result_type;
+
+  explicit Pcg32(uint64_t seed);
+
+  static constexpr result_type
+  min()
+  {
+    return 0;
+  }
+
+  static constexpr result_type
+  max()
+  {
+    return UINT32_MAX;
+  }
+
+  result_type
+  operator()();
+
+  uint64_t state;
+  // selects the sequence, always odd
+  uint64_t increment;
+};
+
+#endif  // SPACETYPER_PCG32_H
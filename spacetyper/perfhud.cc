@@ -0,0 +1,244 @@
+#include "spacetyper/perfhud.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "core/assert.h"
+
+#include "render/fonts.h"
+
+#include "spacetyper/metrics.h"
+
+namespace
+{
+  const int   kGraphFrames = 60;
+  const float kRebuildTime = 0.25f;
+  // the first second includes the loading hitch
+  const int kIgnoredWindows = 1;
+
+  // from a fast frame to two frame budgets or more
+  const char kGraphLevels[] = "_.-=+*#";
+  const int  kGraphLevelCount = sizeof(kGraphLevels) - 1;
+
+  const float kTextSize   = 16.0f;
+  const float kLineHeight = 18.0f;
+
+  float
+  ToMs(float seconds)
+  {
+    return seconds * 1000.0f;
+  }
+
+  char
+  GetGraphLevel(float frame_time, float budget)
+  {
+    const int level =
+        static_cast<int>(frame_time / (2.0f * budget) * kGraphLevelCount);
+    return kGraphLevels[std::max(0, std::min(level, kGraphLevelCount - 1))];
+  }
+}
+
+PerfHud::PerfHud(const GameMetrics* metrics, float target_fps)
+    : metrics_(metrics)
+    , target_fps_(target_fps)
+    , wave_(0)
+    , frames_(kGraphFrames, 0.0f)
+    , next_frame_(0)
+    , render_time_(0.0f)
+    , window_time_(0.0f)
+    , window_frames_(0)
+    , windows_(0)
+    , fps_(0.0f)
+    , dropped_(false)
+    , rebuild_timer_(0.0f)
+    , version_(0)
+{
+  ASSERT(metrics);
+  ASSERT(target_fps > 0.0f);
+}
+
+void
+PerfHud::AddFrame(float dt, float render_time)
+{
+  frames_[next_frame_] = dt;
+  next_frame_          = (next_frame_ + 1) % kGraphFrames;
+  render_time_         = render_time;
+
+  window_time_ += dt;
+  window_frames_ += 1;
+  if(window_time_ >= 1.0f)
+  {
+    fps_ = window_frames_ / window_time_;
+    CheckDrop();
+    window_time_   = 0.0f;
+    window_frames_ = 0;
+  }
+
+  rebuild_timer_ -= dt;
+  if(rebuild_timer_ <= 0.0f)
+  {
+    rebuild_timer_ = kRebuildTime;
+    Rebuild();
+  }
+}
+
+void
+PerfHud::SetWave(int wave)
+{
+  wave_ = wave;
+}
+
+const std::vector<std::string>&
+PerfHud::GetLines() const
+{
+  return lines_;
+}
+
+int
+PerfHud::GetVersion() const
+{
+  return version_;
+}
+
+bool
+PerfHud::GetFirstDrop(std::string* description) const
+{
+  ASSERT(description);
+  if(dropped_)
+  {
+    *description = drop_;
+  }
+  return dropped_;
+}
+
+void
+PerfHud::CheckDrop()
+{
+  windows_ += 1;
+  if(dropped_ || windows_ <= kIgnoredWindows || fps_ >= target_fps_)
+  {
+    return;
+  }
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1) << fps_ << " fps with "
+      << metrics_->GetEnemyCount() << " enemies, "
+      << metrics_->GetBulletCount() << " bullets, "
+      << metrics_->GetParticleCount() << " particles";
+  if(wave_ > 0)
+  {
+    out << " in wave " << wave_;
+  }
+  dropped_ = true;
+  drop_    = out.str();
+}
+
+void
+PerfHud::Rebuild()
+{
+  const float budget = 1.0f / target_fps_;
+
+  // oldest first
+  std::string graph;
+  float       sum   = 0.0f;
+  float       worst = 0.0f;
+  for(int i = 0; i < kGraphFrames; ++i)
+  {
+    const float frame = frames_[(next_frame_ + i) % kGraphFrames];
+    graph += GetGraphLevel(frame, budget);
+    sum += frame;
+    worst = std::max(worst, frame);
+  }
+
+  lines_.clear();
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1);
+
+  out << "fps " << fps_ << "  frame " << ToMs(sum / kGraphFrames)
+      << " ms  worst " << ToMs(worst) << " ms";
+  lines_.push_back(out.str());
+  lines_.push_back(graph);
+
+  // the stages are below a ms on a normal frame
+  out.str("");
+  out << std::setprecision(2);
+  const int stage_count = static_cast<int>(UpdateStage::Count);
+  for(int i = 0; i < stage_count; ++i)
+  {
+    const UpdateStage stage = static_cast<UpdateStage>(i);
+    out << UpdateStageName(stage) << " "
+        << ToMs(metrics_->GetUpdateTime(stage)) << "  ";
+    if(i % 3 == 2 || i == stage_count - 1)
+    {
+      lines_.push_back(out.str() + "ms");
+      out.str("");
+    }
+  }
+  out << "render " << ToMs(render_time_) << " ms";
+  lines_.push_back(out.str());
+
+  out.str("");
+  out << metrics_->GetEnemyCount() << " enemies  "
+      << metrics_->GetBulletCount() << " bullets  "
+      << metrics_->GetParticleCount() << " particles  "
+      << metrics_->GetSpriteCount() << " sprites";
+  lines_.push_back(out.str());
+
+  if(wave_ > 0)
+  {
+    out.str("");
+    out << "wave " << wave_;
+    lines_.push_back(out.str());
+  }
+  if(dropped_)
+  {
+    lines_.push_back("first below target: " + drop_);
+  }
+  version_ += 1;
+}
+
+OverlayText::OverlayText(Font* font)
+    : font_(font)
+{
+}
+
+OverlayText::~OverlayText()
+{
+}
+
+void
+OverlayText::SetLines(const std::vector<std::string>& lines)
+{
+  texts_.resize(lines.size());
+  lines_.resize(lines.size());
+  for(std::size_t i = 0; i < lines.size(); ++i)
+  {
+    if(texts_[i] == nullptr)
+    {
+      texts_[i].reset(new Text(font_));
+      texts_[i]->SetSize(kTextSize);
+      texts_[i]->SetAlignment(Align::TOP_LEFT);
+      texts_[i]->SetBackground(true, 0.5f);
+    }
+    else if(lines_[i] == lines[i])
+    {
+      continue;
+    }
+    ParsedText pt;
+    pt.CreateText(lines[i]);
+    texts_[i]->SetText(pt);
+    lines_[i] = lines[i];
+  }
+}
+
+void
+OverlayText::Draw(SpriteRenderer* renderer, const vec2f& top_left)
+{
+  vec2f position = top_left;
+  for(const auto& text : texts_)
+  {
+    text->Draw(renderer, position, Color::White);
+    position.y -= kLineHeight;
+  }
+}
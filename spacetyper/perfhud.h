@@ -0,0 +1,94 @@
+#ifndef SPACETYPER_PERFHUD_H
+#define SPACETYPER_PERFHUD_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/vec2.h"
+
+class Font;
+class GameMetrics;
+class SpriteRenderer;
+class Text;
+
+// The text of the performance overlay: frame rate, a graph of the last frame
+// times, the update time of every stage, the render time and the entity
+// counts. The lines are rebuilt a few times a second so they stay readable
+// and so the overlay doesn't cost much more than drawing the text.
+class PerfHud
+{
+ public:
+  // the frame rate that counts as keeping up
+  PerfHud(const GameMetrics* metrics, float target_fps);
+
+  // render_time is the time spent drawing or recording the frame
+  void
+  AddFrame(float dt, float render_time);
+
+  // shown when not 0
+  void
+  SetWave(int wave);
+
+  const std::vector<std::string>&
+  GetLines() const;
+
+  // changes every time the lines are rebuilt
+  int
+  GetVersion() const;
+
+  // describes the counts the first time a whole second was below the target
+  // frame rate, returns false if that hasn't happened
+  bool
+  GetFirstDrop(std::string* description) const;
+
+ private:
+  void
+  CheckDrop();
+  void
+  Rebuild();
+
+  const GameMetrics* metrics_;
+  float              target_fps_;
+  int                wave_;
+
+  // ring buffer of the last frame times
+  std::vector<float> frames_;
+  int                next_frame_;
+  float              render_time_;
+
+  // the frames of the current second
+  float window_time_;
+  int   window_frames_;
+  int   windows_;
+  float fps_;
+
+  bool        dropped_;
+  std::string drop_;
+
+  float                    rebuild_timer_;
+  std::vector<std::string> lines_;
+  int                      version_;
+};
+
+// The overlay lines top left aligned, with one text per line that is only
+// laid out again when its line changes.
+class OverlayText
+{
+ public:
+  explicit OverlayText(Font* font);
+  ~OverlayText();
+
+  void
+  SetLines(const std::vector<std::string>& lines);
+
+  void
+  Draw(SpriteRenderer* renderer, const vec2f& top_left);
+
+ private:
+  Font*                              font_;
+  std::vector<std::string>           lines_;
+  std::vector<std::unique_ptr<Text>> texts_;
+};
+
+#endif  // SPACETYPER_PERFHUD_H
@@ -0,0 +1,256 @@
+#include "spacetyper/programcache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "core/assert.h"
+
+namespace
+{
+  const char         kMagic[4] = {'S', 'T', 'P', 'B'};
+  const unsigned int kVersion  = 1;
+  // a linked program is a few kb, anything this big is a broken file
+  const size_t kMaxBinarySize = 64 * 1024 * 1024;
+
+  void
+  WriteUint(std::vector<unsigned char>* out, unsigned int value)
+  {
+    for(int i = 0; i < 4; ++i)
+    {
+      out->push_back(static_cast<unsigned char>((value >> (i * 8)) & 0xff));
+    }
+  }
+
+  unsigned int
+  ReadUint(const unsigned char* in)
+  {
+    return static_cast<unsigned int>(in[0]) |
+           (static_cast<unsigned int>(in[1]) << 8) |
+           (static_cast<unsigned int>(in[2]) << 16) |
+           (static_cast<unsigned int>(in[3]) << 24);
+  }
+
+  struct FileCloser
+  {
+    void
+    operator()(std::FILE* f) const
+    {
+      std::fclose(f);
+    }
+  };
+  typedef std::unique_ptr<std::FILE, FileCloser> FilePtr;
+
+  // fnv-1a
+  void
+  Hash(uint64_t* hash, const void* data, size_t size)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < size; ++i)
+    {
+      *hash ^= bytes[i];
+      *hash *= 1099511628211ull;
+    }
+  }
+
+  void
+  Hash(uint64_t* hash, const std::string& str)
+  {
+    // the length keeps "ab" + "c" and "a" + "bc" apart
+    const uint64_t length = str.length();
+    Hash(hash, &length, sizeof(length));
+    Hash(hash, str.data(), str.length());
+  }
+
+  std::string
+  GetString(GLenum name)
+  {
+    const GLubyte* str = glGetString(name);
+    return str == nullptr ? "" : reinterpret_cast<const char*>(str);
+  }
+}
+
+ProgramCache::ProgramCache(const std::string& folder)
+    : folder_(folder)
+{
+  driver_ = GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" +
+            GetString(GL_VERSION);
+
+  if(!GLEW_ARB_get_program_binary)
+  {
+    return;
+  }
+
+  // mesa reports no formats when its shader disk cache is disabled
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+  if(count > 0)
+  {
+    formats_.resize(count);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats_.data());
+  }
+}
+
+bool
+ProgramCache::IsEnabled() const
+{
+  return !formats_.empty();
+}
+
+bool
+ProgramCache::Load(GLuint program, const std::vector<std::string>& sources)
+{
+  if(!IsEnabled())
+  {
+    return false;
+  }
+
+  const std::string path = GetPath(sources);
+  FilePtr           f{std::fopen(path.c_str(), "rb")};
+  if(f == nullptr)
+  {
+    return false;
+  }
+
+  const uint64_t key = GetKey(sources);
+  unsigned char  header[24];
+  bool           valid =
+      std::fread(header, 1, sizeof(header), f.get()) == sizeof(header) &&
+      std::memcmp(header, kMagic, 4) == 0 &&
+      ReadUint(header + 4) == kVersion &&
+      ReadUint(header + 8) == static_cast<unsigned int>(key) &&
+      ReadUint(header + 12) == static_cast<unsigned int>(key >> 32);
+
+  const GLenum format = valid ? ReadUint(header + 16) : 0;
+  const size_t size   = valid ? ReadUint(header + 20) : 0;
+  valid = valid && size > 0 && size <= kMaxBinarySize &&
+          std::find(formats_.begin(), formats_.end(), format) !=
+              formats_.end();
+
+  std::vector<unsigned char> binary;
+  if(valid)
+  {
+    binary.resize(size);
+    valid = std::fread(binary.data(), 1, size, f.get()) == size;
+  }
+
+  GLint linked = GL_FALSE;
+  if(valid)
+  {
+    glProgramBinary(program, format, binary.data(), binary.size());
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  }
+
+  if(linked != GL_TRUE)
+  {
+    // rejected or broken, compile it and replace the file
+    f.reset();
+    std::remove(path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void
+ProgramCache::PrepareLink(GLuint program)
+{
+  if(IsEnabled())
+  {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+}
+
+bool
+ProgramCache::Store(
+    GLuint                          program,
+    const std::vector<std::string>& sources,
+    std::string*                    error)
+{
+  ASSERT(error);
+  if(!IsEnabled())
+  {
+    return false;
+  }
+
+  GLint linked = GL_FALSE;
+  GLint size   = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+  if(linked != GL_TRUE || size <= 0)
+  {
+    *error = "The driver didn't return a program binary";
+    return false;
+  }
+
+  std::vector<unsigned char> binary(size);
+  GLsizei                    length = 0;
+  GLenum                     format = 0;
+  glGetProgramBinary(program, size, &length, &format, binary.data());
+  if(length <= 0)
+  {
+    *error = "The driver didn't return a program binary";
+    return false;
+  }
+  binary.resize(length);
+
+  const uint64_t             key = GetKey(sources);
+  std::vector<unsigned char> header(kMagic, kMagic + 4);
+  WriteUint(&header, kVersion);
+  WriteUint(&header, static_cast<unsigned int>(key));
+  WriteUint(&header, static_cast<unsigned int>(key >> 32));
+  WriteUint(&header, format);
+  WriteUint(&header, binary.size());
+
+  // write to a temporary file so a crash never leaves a truncated binary
+  const std::string path      = GetPath(sources);
+  const std::string temporary = path + ".tmp";
+  FilePtr           f{std::fopen(temporary.c_str(), "wb")};
+  if(f == nullptr)
+  {
+    *error = "Unable to open " + temporary + " for writing";
+    return false;
+  }
+
+  const bool ok =
+      std::fwrite(header.data(), 1, header.size(), f.get()) == header.size() &&
+      std::fwrite(binary.data(), 1, binary.size(), f.get()) == binary.size() &&
+      std::fclose(f.release()) == 0;
+  // rename doesn't replace existing files on windows
+  std::remove(path.c_str());
+  if(!ok || std::rename(temporary.c_str(), path.c_str()) != 0)
+  {
+    f.reset();
+    std::remove(temporary.c_str());
+    *error = "Failed to write " + path;
+    return false;
+  }
+
+  return true;
+}
+
+std::string
+ProgramCache::GetPath(const std::vector<std::string>& sources) const
+{
+  char name[32];
+  std::snprintf(
+      name,
+      sizeof(name),
+      "%016llx.bin",
+      static_cast<unsigned long long>(GetKey(sources)));
+  return folder_ + "/shadercache-" + name;
+}
+
+uint64_t
+ProgramCache::GetKey(const std::vector<std::string>& sources) const
+{
+  uint64_t hash = 14695981039346656037ull;
+  Hash(&hash, &kVersion, sizeof(kVersion));
+  Hash(&hash, driver_);
+  for(const std::string& source : sources)
+  {
+    Hash(&hash, source);
+  }
+  return hash;
+}
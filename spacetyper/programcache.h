@@ -0,0 +1,52 @@
+#ifndef SPACETYPER_PROGRAMCACHE_H
+#define SPACETYPER_PROGRAMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Keeps linked shader programs on disk so they don't have to be compiled at
+// every launch. The binaries are keyed by a hash of the shader sources and
+// the driver vendor, renderer and version so a driver update or a changed
+// shader never loads a stale binary, and a binary the driver rejects anyway
+// is removed so the program is compiled and cached again.
+class ProgramCache
+{
+ public:
+  // needs a current context with glew initialized
+  explicit ProgramCache(const std::string& folder);
+
+  // false if the driver doesn't support any binary formats
+  bool
+  IsEnabled() const;
+
+  // returns true if the cached binary was accepted and the program is linked
+  bool
+  Load(GLuint program, const std::vector<std::string>& sources);
+
+  // call before linking so the driver keeps the binary around
+  void
+  PrepareLink(GLuint program);
+
+  // stores the binary of a program that was linked after PrepareLink
+  bool
+  Store(
+      GLuint                          program,
+      const std::vector<std::string>& sources,
+      std::string*                    error);
+
+  std::string
+  GetPath(const std::vector<std::string>& sources) const;
+
+ private:
+  uint64_t
+  GetKey(const std::vector<std::string>& sources) const;
+
+  std::string        folder_;
+  std::string        driver_;
+  std::vector<GLint> formats_;
+};
+
+#endif  // SPACETYPER_PROGRAMCACHE_H
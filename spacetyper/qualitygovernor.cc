@@ -0,0 +1,86 @@
+#include "spacetyper/qualitygovernor.h"
+
+#include <algorithm>
+
+namespace
+{
+  // degrade quickly when over, recover slowly when well under
+  const float kDegradeAt    = 0.9f;
+  const float kRecoverAt    = 0.6f;
+  const int   kLevels       = 10;
+  const int   kDegradeSteps = 2;
+  const float kCooldownTime = 0.5f;
+
+  // roughly the last 10 frames
+  const float kSmoothing = 0.1f;
+
+  float
+  Lerp(float from, float to, float t)
+  {
+    return from + (to - from) * t;
+  }
+}
+
+EffectsQuality::EffectsQuality()
+    : emission(1.0f)
+    , lifetime(1.0f)
+    , particle_budget(1000)
+    , star_density(1.0f)
+    , label_backgrounds(true)
+{
+}
+
+QualityGovernor::QualityGovernor(float frame_budget)
+    : frame_budget_(frame_budget)
+    , average_(0.0f)
+    , level_(kLevels)
+    , cooldown_(0.0f)
+{
+}
+
+bool
+QualityGovernor::AddFrameTime(float cost, float dt)
+{
+  average_ = Lerp(average_, cost, kSmoothing);
+  cooldown_ -= dt;
+  if(cooldown_ > 0.0f)
+  {
+    return false;
+  }
+
+  const int old = level_;
+  if(average_ > frame_budget_ * kDegradeAt)
+  {
+    level_ = std::max(0, level_ - kDegradeSteps);
+  }
+  else if(average_ < frame_budget_ * kRecoverAt)
+  {
+    level_ = std::min(kLevels, level_ + 1);
+  }
+
+  if(level_ == old)
+  {
+    return false;
+  }
+  cooldown_ = kCooldownTime;
+  return true;
+}
+
+float
+QualityGovernor::GetQuality() const
+{
+  return static_cast<float>(level_) / kLevels;
+}
+
+EffectsQuality
+QualityGovernor::GetEffects() const
+{
+  const float    quality = GetQuality();
+  EffectsQuality effects;
+  effects.emission          = Lerp(0.25f, 1.0f, quality);
+  effects.lifetime          = Lerp(0.5f, 1.0f, quality);
+  effects.particle_budget   = static_cast<int>(Lerp(100.0f, 1000.0f, quality));
+  effects.star_density      = Lerp(0.3f, 1.0f, quality);
+  effects.label_backgrounds = quality > 0.5f;
+  return effects;
+}
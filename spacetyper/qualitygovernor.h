@@ -0,0 +1,50 @@
+#ifndef SPACETYPER_QUALITYGOVERNOR_H
+#define SPACETYPER_QUALITYGOVERNOR_H
+
+// What the effects are allowed to cost, scaled by the governor.
+struct EffectsQuality
+{
+  EffectsQuality();
+
+  // fraction of the requested particles that are spawned
+  float emission;
+  // scale of the particle lifetime
+  float lifetime;
+  // max particles alive at once
+  int particle_budget;
+  // fraction of the stars that are drawn
+  float star_density;
+  bool  label_backgrounds;
+};
+
+// Watches how long the frames take to simulate and draw, excluding the wait
+// for vsync, and lowers the effects quality when they get close to the frame
+// budget and slowly raises it again when there is room.
+class QualityGovernor
+{
+ public:
+  explicit QualityGovernor(float frame_budget);
+
+  // cost is the work of the frame, dt the wall time since the last frame,
+  // returns true if the quality changed
+  bool
+  AddFrameTime(float cost, float dt);
+
+  // 0 is the cheapest, 1 is full quality
+  float
+  GetQuality() const;
+
+  EffectsQuality
+  GetEffects() const;
+
+ private:
+  float frame_budget_;
+  float average_;
+  // quality in steps of a tenth
+  int   level_;
+  // time until the quality may change again, so one change has time to
+  // show up in the average before the next
+  float cooldown_;
+};
+
+#endif  // SPACETYPER_QUALITYGOVERNOR_H
@@ -0,0 +1,159 @@
+#include "spacetyper/rendercommands.h"
+
+#include "core/assert.h"
+
+#include "render/scalablesprite.h"
+#include "render/spriterender.h"
+
+#include "spacetyper/enemyword.h"
+#include "spacetyper/gameassets.h"
+
+RenderCommandList::RenderCommandList()
+    : label_backgrounds(true)
+    , has_target(false)
+    , target{vec2f(0.0f), 0.0f, 0.0f}
+    , gui_running(false)
+    , mouse(0.0f)
+    , mouse_down(false)
+    , dt(0.0f)
+    , show_overlay(false)
+    , overlay_changed(false)
+    , overlay_position(0.0f)
+{
+}
+
+void
+RenderCommandList::Clear()
+{
+  background.clear();
+  objects.clear();
+  labels.clear();
+  label_words.clear();
+  foreground.clear();
+  has_target      = false;
+  show_overlay    = false;
+  overlay_changed = false;
+  overlay.clear();
+}
+
+CommandRenderer::CommandRenderer(
+    const GameAssets* assets, ScalableSprite* target)
+    : font_(assets->font)
+    , target_(target)
+    , label_backgrounds_(true)
+    , frame_(0)
+{
+  ASSERT(target);
+  AddSprite(assets->small_star);
+  AddSprite(assets->big_star);
+  AddSprite(assets->player);
+  AddSprite(assets->enemy);
+  AddSprite(assets->bullet);
+  for(const auto& texture : assets->effects)
+  {
+    AddSprite(texture);
+  }
+}
+
+void
+CommandRenderer::Draw(const RenderCommandList& list, SpriteRenderer* renderer)
+{
+  DrawSprites(list.background, renderer);
+  DrawSprites(list.objects, renderer);
+
+  UpdateLabels(list);
+  for(const LabelCommand& l : list.labels)
+  {
+    const auto found = labels_.find(l.label);
+    ASSERT(found != labels_.end());
+    Label& label = found->second;
+    if(label.typed != l.typed)
+    {
+      label.typed = l.typed;
+      ParsedText pt;
+      HighlightString(&pt, label.word, 0, label.typed);
+      label.text->SetText(pt);
+    }
+    label.frame = frame_;
+    label.text->Draw(renderer, l.position, Color::White, Color::Blue);
+  }
+
+  // labels that weren't drawn are recorded with their word again if they
+  // come back
+  for(auto it = labels_.begin(); it != labels_.end();)
+  {
+    if(it->second.frame != frame_)
+    {
+      it = labels_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  frame_ += 1;
+
+  DrawSprites(list.foreground, renderer);
+
+  if(list.has_target)
+  {
+    renderer->DrawNinepatch(
+        *target_,
+        Rectf::FromPositionAnchorWidthAndHeight(
+            list.target.center,
+            vec2f{0.5f, 0.5f},
+            list.target.width,
+            list.target.height),
+        Rgba{Color::White});
+  }
+}
+
+void
+CommandRenderer::AddSprite(const std::shared_ptr<Texture2d>& texture)
+{
+  sprites_.emplace(texture.get(), Sprite{texture});
+}
+
+void
+CommandRenderer::DrawSprites(
+    const std::vector<SpriteCommand>& sprites, SpriteRenderer* renderer)
+{
+  for(const SpriteCommand& command : sprites)
+  {
+    const auto found = sprites_.find(command.texture);
+    ASSERT(found != sprites_.end());
+    Sprite& sprite = found->second;
+    sprite.SetPosition(command.position);
+    sprite.rotation = command.rotation;
+    sprite.SetAlpha(command.alpha);
+    sprite.Render(renderer);
+  }
+}
+
+void
+CommandRenderer::UpdateLabels(const RenderCommandList& list)
+{
+  if(list.label_backgrounds != label_backgrounds_)
+  {
+    label_backgrounds_ = list.label_backgrounds;
+    for(auto& label : labels_)
+    {
+      SetEnemyLabelBackground(label.second.text.get(), label_backgrounds_);
+    }
+  }
+
+  for(const LabelWordCommand& word : list.label_words)
+  {
+    Label label;
+    label.word  = word.word;
+    label.typed = 0;
+    label.frame = frame_;
+    label.text.reset(new Text(font_));
+    SetupEnemyLabel(label.text.get());
+    SetEnemyLabelBackground(label.text.get(), label_backgrounds_);
+    ParsedText pt;
+    HighlightString(&pt, label.word, 0, label.typed);
+    label.text->SetText(pt);
+    labels_[word.label] = std::move(label);
+  }
+}
@@ -0,0 +1,125 @@
+#ifndef SPACETYPER_RENDERCOMMANDS_H
+#define SPACETYPER_RENDERCOMMANDS_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/angle.h"
+#include "core/vec2.h"
+#include "render/fonts.h"
+#include "render/sprite.h"
+
+class GameAssets;
+class SpriteRenderer;
+class ScalableSprite;
+class Texture2d;
+
+// the texture is one of the game assets so it outlives the list
+struct SpriteCommand
+{
+  const Texture2d* texture;
+  vec2f            position;
+  Angle            rotation;
+  float            alpha;
+};
+
+// enemy label, the word is only recorded as a LabelWordCommand the first
+// frame the label is drawn
+struct LabelCommand
+{
+  int          label;
+  unsigned int typed;
+  vec2f        position;
+};
+
+struct LabelWordCommand
+{
+  int         label;
+  std::string word;
+};
+
+struct NinepatchCommand
+{
+  vec2f center;
+  float width;
+  float height;
+};
+
+// Everything needed to draw one frame, recorded by the simulation and
+// consumed by the render thread without touching the simulation. Every
+// recorded list must be drawn since labels not drawn in a frame are
+// forgotten.
+struct RenderCommandList
+{
+  RenderCommandList();
+
+  // keeps the allocated memory for the next frame
+  void
+  Clear();
+
+  std::vector<SpriteCommand>    background;
+  std::vector<SpriteCommand>    objects;
+  std::vector<LabelCommand>     labels;
+  std::vector<LabelWordCommand> label_words;
+  bool                          label_backgrounds;
+  std::vector<SpriteCommand>    foreground;
+
+  bool             has_target;
+  NinepatchCommand target;
+
+  // the gui is stepped on the render thread so it is only touched there
+  bool  gui_running;
+  vec2f mouse;
+  bool  mouse_down;
+  float dt;
+
+  // the performance overlay, drawn last. The render thread keeps the lines,
+  // they are only recorded in the frames they changed in
+  bool                     show_overlay;
+  bool                     overlay_changed;
+  std::vector<std::string> overlay;
+  vec2f                    overlay_position;
+};
+
+// Draws command lists with one sprite per game texture that is moved to
+// every sprite command, and keeps the laid out labels so a label is only
+// laid out again when its typed count changes.
+class CommandRenderer
+{
+ public:
+  CommandRenderer(const GameAssets* assets, ScalableSprite* target);
+
+  void
+  Draw(const RenderCommandList& list, SpriteRenderer* renderer);
+
+ private:
+  struct Label
+  {
+    std::string           word;
+    unsigned int          typed;
+    int                   frame;
+    std::unique_ptr<Text> text;
+  };
+
+  void
+  AddSprite(const std::shared_ptr<Texture2d>& texture);
+
+  void
+  DrawSprites(
+      const std::vector<SpriteCommand>& sprites, SpriteRenderer* renderer);
+
+  void
+  UpdateLabels(const RenderCommandList& list);
+
+  Font*           font_;
+  ScalableSprite* target_;
+
+  std::unordered_map<const Texture2d*, Sprite> sprites_;
+  std::unordered_map<int, Label>               labels_;
+  bool                                         label_backgrounds_;
+  int                                          frame_;
+};
+
+#endif  // SPACETYPER_RENDERCOMMANDS_H
@@ -0,0 +1,145 @@
+#include "spacetyper/renderthread.h"
+
+#include "gui/root.h"
+#include "render/init.h"
+
+#include "spacetyper/gameassets.h"
+#include "spacetyper/perfhud.h"
+
+RenderThread::RenderThread(
+    SDL_Window*       window,
+    SDL_GLContext     context,
+    Init*             init,
+    SpriteRenderer*   renderer,
+    const GameAssets* assets,
+    ScalableSprite*   target,
+    Root*             gui)
+    : window_(window)
+    , context_(context)
+    , init_(init)
+    , renderer_(renderer)
+    , commands_(assets, target)
+    , overlay_(assets->font)
+    , gui_(gui)
+    , running_(false)
+    , frames_rendered_(0)
+    , render_time_(0.0f)
+{
+}
+
+RenderThread::~RenderThread()
+{
+  Stop();
+}
+
+void
+RenderThread::Start()
+{
+  ASSERT(!running_);
+  SDL_GL_MakeCurrent(window_, nullptr);
+  running_ = true;
+  thread_  = std::thread(&RenderThread::Run, this);
+}
+
+void
+RenderThread::Stop()
+{
+  if(!running_)
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  submitted_.notify_one();
+  fetched_.notify_one();
+  thread_.join();
+  SDL_GL_MakeCurrent(window_, context_);
+}
+
+RenderCommandList*
+RenderThread::BeginFrame()
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    fetched_.wait(
+        lock, [this]() { return !frames_.HasPending() || !running_; });
+  }
+  RenderCommandList* list = &frames_.GetWriteBuffer();
+  list->Clear();
+  return list;
+}
+
+void
+RenderThread::Submit()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_.Publish();
+  }
+  submitted_.notify_one();
+}
+
+int
+RenderThread::GetFramesRendered() const
+{
+  return frames_rendered_;
+}
+
+float
+RenderThread::GetRenderTime() const
+{
+  return render_time_;
+}
+
+void
+RenderThread::Run()
+{
+  SDL_GL_MakeCurrent(window_, context_);
+
+  for(;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      submitted_.wait(
+          lock, [this]() { return frames_.HasPending() || !running_; });
+      if(!running_)
+      {
+        break;
+      }
+      frames_.Fetch();
+    }
+    fetched_.notify_one();
+
+    const Uint64       start = SDL_GetPerformanceCounter();
+    RenderCommandList& list  = frames_.GetReadBuffer();
+    if(list.gui_running)
+    {
+      gui_->SetInputMouse(list.mouse, list.mouse_down);
+      gui_->Step(list.dt);
+    }
+
+    init_->ClearScreen(Color::DarkslateGray);
+    commands_.Draw(list, renderer_);
+    if(list.gui_running)
+    {
+      gui_->Render(renderer_);
+    }
+    if(list.overlay_changed)
+    {
+      overlay_.SetLines(list.overlay);
+    }
+    if(list.show_overlay)
+    {
+      overlay_.Draw(renderer_, list.overlay_position);
+    }
+
+    render_time_ = (SDL_GetPerformanceCounter() - start) * 1.0f /
+                   SDL_GetPerformanceFrequency();
+    SDL_GL_SwapWindow(window_);
+    ++frames_rendered_;
+  }
+
+  SDL_GL_MakeCurrent(window_, nullptr);
+}
@@ -0,0 +1,83 @@
+#ifndef SPACETYPER_RENDERTHREAD_H
+#define SPACETYPER_RENDERTHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <SDL2/SDL.h>
+
+#include "spacetyper/perfhud.h"
+#include "spacetyper/rendercommands.h"
+#include "spacetyper/triplebuffer.h"
+
+class GameAssets;
+class Init;
+class Root;
+class ScalableSprite;
+class SpriteRenderer;
+
+// Owns the gl context while running and draws the command lists the
+// simulation thread submits. Everything gl, including the gui, must be
+// loaded before Start and only used by this thread until Stop returns.
+class RenderThread
+{
+ public:
+  RenderThread(
+      SDL_Window*       window,
+      SDL_GLContext     context,
+      Init*             init,
+      SpriteRenderer*   renderer,
+      const GameAssets* assets,
+      ScalableSprite*   target,
+      Root*             gui);
+  ~RenderThread();
+
+  void
+  Start();
+
+  // hands the context back to the calling thread
+  void
+  Stop();
+
+  // the list to record the next frame to, waits if the render thread hasn't
+  // picked up the last frame yet so the simulation is at most a frame ahead
+  RenderCommandList*
+  BeginFrame();
+
+  void
+  Submit();
+
+  int
+  GetFramesRendered() const;
+
+  // seconds the last frame took to draw, without the swap
+  float
+  GetRenderTime() const;
+
+ private:
+  void
+  Run();
+
+  SDL_Window*     window_;
+  SDL_GLContext   context_;
+  Init*           init_;
+  SpriteRenderer* renderer_;
+  CommandRenderer commands_;
+  OverlayText     overlay_;
+  Root*           gui_;
+
+  TripleBuffer<RenderCommandList> frames_;
+  std::atomic<bool>               running_;
+  std::atomic<int>                frames_rendered_;
+  std::atomic<float>              render_time_;
+  std::thread                     thread_;
+
+  // both threads sleep until the other one has submitted or fetched a frame
+  std::mutex              mutex_;
+  std::condition_variable submitted_;
+  std::condition_variable fetched_;
+};
+
+#endif  // SPACETYPER_RENDERTHREAD_H
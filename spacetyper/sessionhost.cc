@@ -0,0 +1,137 @@
+#include "spacetyper/sessionhost.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include "spacetyper/enemies.h"
+#include "spacetyper/enemyword.h"
+#include "spacetyper/gamesession.h"
+#include "spacetyper/textinput.h"
+
+SessionHost::SessionHost(
+    const GameAssets* assets,
+    const Dictionary* dictionary,
+    int               width,
+    int               height,
+    int               session_count,
+    unsigned int      seed,
+    int               worker_count)
+    : worker_count_(worker_count)
+{
+  if(worker_count_ <= 0)
+  {
+    worker_count_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+  worker_count_ = std::max(1, std::min(worker_count_, session_count));
+
+  std::mt19937 generator(seed);
+  sessions_.reserve(session_count);
+  for(int i = 0; i < session_count; ++i)
+  {
+    sessions_.emplace_back(new GameSession(
+        assets, dictionary, nullptr, width, height, generator()));
+  }
+}
+
+SessionHost::~SessionHost()
+{
+}
+
+void
+SessionHost::Run(int ticks, float dt, const SessionController& controller)
+{
+  const int count = GetSessionCount();
+  auto      work  = [&](int worker) {
+    const int begin = count * worker / worker_count_;
+    const int end   = count * (worker + 1) / worker_count_;
+    for(int tick = 0; tick < ticks; ++tick)
+    {
+      for(int i = begin; i < end; ++i)
+      {
+        GameSession* session = sessions_[i].get();
+        if(controller)
+        {
+          controller(i, session, dt);
+        }
+        session->Update(dt);
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(int worker = 1; worker < worker_count_; ++worker)
+  {
+    workers.emplace_back(work, worker);
+  }
+  work(0);
+  for(std::thread& t : workers)
+  {
+    t.join();
+  }
+}
+
+int
+SessionHost::GetWorkerCount() const
+{
+  return worker_count_;
+}
+
+int
+SessionHost::GetSessionCount() const
+{
+  return static_cast<int>(sessions_.size());
+}
+
+GameSession*
+SessionHost::GetSession(int index)
+{
+  return sessions_[index].get();
+}
+
+AutoTyper::AutoTyper(int session_count, float chars_per_second)
+    : delay_(1.0f / chars_per_second)
+    , timers_(session_count, 0.0f)
+{
+}
+
+void
+AutoTyper::SetSpeed(float chars_per_second)
+{
+  delay_ = 1.0f / chars_per_second;
+}
+
+void
+AutoTyper::operator()(int index, GameSession* session, float dt)
+{
+  float& timer = timers_[index];
+  timer -= dt;
+  if(timer > 0.0f)
+  {
+    return;
+  }
+  timer += delay_;
+
+  Enemies* enemies = session->GetEnemies();
+  if(enemies->EnemyCount() == 0)
+  {
+    enemies->SpawnEnemies(5);
+  }
+
+  const EnemyWord* word = session->GetCurrentWord();
+  if(word == nullptr)
+  {
+    word = enemies->GetLowest();
+  }
+  if(word == nullptr)
+  {
+    return;
+  }
+
+  // the whole code point, a single byte of it would never match
+  char32_t           codepoint = 0;
+  const std::string& w         = word->GetWord();
+  const std::size_t  length =
+      DecodeUtf8(w, word->GetTypedCount(), &codepoint);
+  session->Type(w.substr(word->GetTypedCount(), length));
+}
@@ -0,0 +1,68 @@
+#ifndef SPACETYPER_SESSIONHOST_H
+#define SPACETYPER_SESSIONHOST_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class GameAssets;
+class Dictionary;
+class GameSession;
+
+// called for every session before each update, for bots and replays.
+// Called from the worker thread that owns the session.
+typedef std::function<void(int index, GameSession* session, float dt)>
+    SessionController;
+
+// Runs many headless sessions, the sessions are split in one fixed shard per
+// worker so workers never touch the same session and never need to sync
+// while running.
+class SessionHost
+{
+ public:
+  // 0 workers means one per core
+  SessionHost(
+      const GameAssets* assets,
+      const Dictionary* dictionary,
+      int               width,
+      int               height,
+      int               session_count,
+      unsigned int      seed,
+      int               worker_count);
+  ~SessionHost();
+
+  void
+  Run(int ticks, float dt, const SessionController& controller);
+
+  int
+  GetWorkerCount() const;
+
+  int
+  GetSessionCount() const;
+
+  GameSession*
+  GetSession(int index);
+
+ private:
+  std::vector<std::unique_ptr<GameSession>> sessions_;
+  int                                       worker_count_;
+};
+
+// a bot that types the word closest to the bottom at a steady speed
+class AutoTyper
+{
+ public:
+  AutoTyper(int session_count, float chars_per_second);
+
+  void
+  SetSpeed(float chars_per_second);
+
+  void
+  operator()(int index, GameSession* session, float dt);
+
+ private:
+  float              delay_;
+  std::vector<float> timers_;
+};
+
+#endif  // SPACETYPER_SESSIONHOST_H
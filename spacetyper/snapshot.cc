@@ -0,0 +1,286 @@
+#include "spacetyper/snapshot.h"
+
+#include <cstring>
+
+namespace
+{
+  const uint32_t kIdBits = 24;
+
+  // key and byte count
+  const std::size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+}
+
+SnapshotWriter::SnapshotWriter(std::vector<char>* data, SnapshotMode mode)
+    : data_(data)
+    , mode_(mode)
+    , record_(std::string::npos)
+{
+  ASSERT(data);
+  data_->clear();
+}
+
+SnapshotMode
+SnapshotWriter::GetMode() const
+{
+  return mode_;
+}
+
+void
+SnapshotWriter::BeginRecord(SnapshotRecord kind, uint32_t id)
+{
+  ASSERT(record_ == std::string::npos);
+  ASSERT(kind != SnapshotRecord::None);
+  ASSERT(id <= kMaxRecordId);
+  const uint32_t key = (static_cast<uint32_t>(kind) << kIdBits) | id;
+  // the byte count is filled in by EndRecord
+  const uint32_t header[2] = {key, 0};
+  const char*    bytes     = reinterpret_cast<const char*>(header);
+  record_                  = data_->size() + sizeof(key);
+  data_->insert(data_->end(), bytes, bytes + sizeof(header));
+}
+
+void
+SnapshotWriter::EndRecord()
+{
+  ASSERT(record_ != std::string::npos);
+  const uint32_t size =
+      static_cast<uint32_t>(data_->size() - record_ - sizeof(uint32_t));
+  std::memcpy(&(*data_)[record_], &size, sizeof(size));
+  record_ = std::string::npos;
+}
+
+void
+SnapshotWriter::WriteInt(int value)
+{
+  Write(&value, sizeof(value));
+}
+
+void
+SnapshotWriter::WriteFloat(float value)
+{
+  Write(&value, sizeof(value));
+}
+
+void
+SnapshotWriter::WriteDouble(double value)
+{
+  Write(&value, sizeof(value));
+}
+
+void
+SnapshotWriter::WriteVec2(const vec2f& value)
+{
+  WriteFloat(value.x);
+  WriteFloat(value.y);
+}
+
+void
+SnapshotWriter::WriteString(const std::string& value)
+{
+  WriteInt(static_cast<int>(value.size()));
+  Write(value.data(), value.size());
+}
+
+void
+SnapshotWriter::WriteGenerator(const Pcg32& generator)
+{
+  if(mode_ == SnapshotMode::View)
+  {
+    return;
+  }
+  Write(&generator.state, sizeof(generator.state));
+  Write(&generator.increment, sizeof(generator.increment));
+}
+
+void
+SnapshotWriter::Write(const void* source, std::size_t size)
+{
+  ASSERT(record_ != std::string::npos);
+  const char* bytes = static_cast<const char*>(source);
+  data_->insert(data_->end(), bytes, bytes + size);
+}
+
+SnapshotReader::SnapshotReader(const std::vector<char>& data)
+    : data_(data)
+    , mode_(SnapshotMode::Simulation)
+    , position_(0)
+    , record_end_(0)
+    , ok_(true)
+{
+}
+
+void
+SnapshotReader::SetMode(SnapshotMode mode)
+{
+  mode_ = mode;
+}
+
+SnapshotRecord
+SnapshotReader::PeekRecord() const
+{
+  uint32_t key = 0;
+  if(!ok_ || position_ != record_end_ ||
+     data_.size() - position_ < kRecordHeaderSize)
+  {
+    return SnapshotRecord::None;
+  }
+  std::memcpy(&key, &data_[position_], sizeof(key));
+  return static_cast<SnapshotRecord>(key >> kIdBits);
+}
+
+uint32_t
+SnapshotReader::BeginRecord(SnapshotRecord kind)
+{
+  ASSERT(kind != SnapshotRecord::None);
+  uint32_t key  = 0;
+  uint32_t size = 0;
+  if(PeekRecord() != kind)
+  {
+    Fail();
+    return 0;
+  }
+  std::memcpy(&key, &data_[position_], sizeof(key));
+  std::memcpy(&size, &data_[position_ + sizeof(key)], sizeof(size));
+  if(data_.size() - position_ - kRecordHeaderSize < size)
+  {
+    Fail();
+    return 0;
+  }
+  position_ += kRecordHeaderSize;
+  record_end_ = position_ + size;
+  return key & kMaxRecordId;
+}
+
+void
+SnapshotReader::EndRecord()
+{
+  if(position_ != record_end_)
+  {
+    Fail();
+  }
+}
+
+int
+SnapshotReader::ReadInt()
+{
+  int value = 0;
+  Read(&value, sizeof(value));
+  return value;
+}
+
+float
+SnapshotReader::ReadFloat()
+{
+  float value = 0.0f;
+  Read(&value, sizeof(value));
+  return value;
+}
+
+double
+SnapshotReader::ReadDouble()
+{
+  double value = 0.0;
+  Read(&value, sizeof(value));
+  return value;
+}
+
+vec2f
+SnapshotReader::ReadVec2()
+{
+  const float x = ReadFloat();
+  const float y = ReadFloat();
+  return vec2f{x, y};
+}
+
+std::string
+SnapshotReader::ReadString()
+{
+  const int size = ReadCount(1);
+  if(size == 0)
+  {
+    return "";
+  }
+  std::string value(size, ' ');
+  Read(&value[0], size);
+  return value;
+}
+
+void
+SnapshotReader::ReadGenerator(Pcg32* generator)
+{
+  ASSERT(generator);
+  if(mode_ == SnapshotMode::View)
+  {
+    return;
+  }
+  uint64_t state     = 0;
+  uint64_t increment = 0;
+  Read(&state, sizeof(state));
+  Read(&increment, sizeof(increment));
+  // an even increment is never written, the generator would be broken
+  if(!IsOk() || (increment & 1u) == 0)
+  {
+    Fail();
+    return;
+  }
+  generator->state     = state;
+  generator->increment = increment;
+}
+
+int
+SnapshotReader::ReadCount(std::size_t min_item_size)
+{
+  ASSERT(min_item_size > 0);
+  const int count = ReadInt();
+  if(count < 0 ||
+     static_cast<std::size_t>(count) >
+         (record_end_ - position_) / min_item_size)
+  {
+    Fail();
+    return 0;
+  }
+  return count;
+}
+
+int
+SnapshotReader::ReadIndex(int size)
+{
+  const int index = ReadInt();
+  if(index < -1 || index >= size)
+  {
+    Fail();
+    return -1;
+  }
+  return index;
+}
+
+void
+SnapshotReader::Fail()
+{
+  ok_ = false;
+}
+
+bool
+SnapshotReader::IsOk() const
+{
+  return ok_;
+}
+
+bool
+SnapshotReader::IsAtEnd() const
+{
+  return position_ == data_.size();
+}
+
+bool
+SnapshotReader::Read(void* dest, std::size_t size)
+{
+  if(ok_ == false || record_end_ - position_ < size)
+  {
+    ok_ = false;
+    return false;
+  }
+  std::memcpy(dest, &data_[position_], size);
+  position_ += size;
+  return true;
+}
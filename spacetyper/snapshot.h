@@ -0,0 +1,161 @@
+#ifndef SPACETYPER_SNAPSHOT_H
+#define SPACETYPER_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/vec2.h"
+
+#include "spacetyper/pcg32.h"
+
+// Snapshots are plain native endian bytes, meant to be kept in memory and
+// restored on the same machine, not to be shipped between builds.
+//
+// A snapshot is a list of records, each a uint32 key, a uint32 byte count
+// and the bytes. The top byte of the key is what the record holds and the
+// rest is an id that stays the same for as long as the thing lives, so a
+// spectator delta can match the records of two snapshots by key.
+enum class SnapshotRecord
+{
+  None,
+  Session,
+  Stars,
+  Enemies,
+  Enemy,
+  Bullets,
+  Bullet,
+  Particles,
+  Particle
+};
+
+// ids have 24 bits, the counters that hand them out wrap around
+const uint32_t kMaxRecordId = (1u << 24) - 1;
+
+// a spectator only shows the session, so its snapshots leave out the
+// generators that are only needed to keep simulating it
+enum class SnapshotMode
+{
+  Simulation,
+  View
+};
+
+class SnapshotWriter
+{
+ public:
+  // clears the data
+  SnapshotWriter(std::vector<char>* data, SnapshotMode mode);
+
+  SnapshotMode
+  GetMode() const;
+
+  // every value is written between a BeginRecord and an EndRecord
+  void
+  BeginRecord(SnapshotRecord kind, uint32_t id);
+  void
+  EndRecord();
+
+  void
+  WriteInt(int value);
+
+  void
+  WriteFloat(float value);
+
+  void
+  WriteDouble(double value);
+
+  void
+  WriteVec2(const vec2f& value);
+
+  void
+  WriteString(const std::string& value);
+
+  // nothing is written in view mode
+  void
+  WriteGenerator(const Pcg32& generator);
+
+ private:
+  void
+  Write(const void* source, std::size_t size);
+
+  std::vector<char>* data_;
+  SnapshotMode       mode_;
+  // where the byte count of the open record goes, npos when none is open
+  std::size_t record_;
+};
+
+// Reading past the end or reading a bad value marks the reader as failed,
+// after that every read returns a zero value so callers can check IsOk()
+// once at the end instead of after every read. Reading outside a record or
+// past the end of one fails as well.
+class SnapshotReader
+{
+ public:
+  explicit SnapshotReader(const std::vector<char>& data);
+
+  // the mode is part of the session record, the generators read before it
+  // is set are read as in simulation mode
+  void
+  SetMode(SnapshotMode mode);
+
+  // the kind of the next record, None at the end or after a failure
+  SnapshotRecord
+  PeekRecord() const;
+
+  // fails unless the next record is of the given kind, returns its id
+  uint32_t
+  BeginRecord(SnapshotRecord kind);
+  // fails unless all of the record was read
+  void
+  EndRecord();
+
+  int
+  ReadInt();
+
+  float
+  ReadFloat();
+
+  double
+  ReadDouble();
+
+  vec2f
+  ReadVec2();
+
+  std::string
+  ReadString();
+
+  // leaves the generator as it is in view mode
+  void
+  ReadGenerator(Pcg32* generator);
+
+  // a count of items that are at least min_item_size bytes each, checked
+  // against the rest of the record so a broken snapshot can't allocate forever
+  int
+  ReadCount(std::size_t min_item_size);
+
+  // an index in [-1, size) where -1 means none
+  int
+  ReadIndex(int size);
+
+  void
+  Fail();
+
+  bool
+  IsOk() const;
+
+  bool
+  IsAtEnd() const;
+
+ private:
+  bool
+  Read(void* dest, std::size_t size);
+
+  const std::vector<char>& data_;
+  SnapshotMode             mode_;
+  std::size_t              position_;
+  // the end of the open record, position_ when none is open
+  std::size_t record_end_;
+  bool        ok_;
+};
+
+#endif  // SPACETYPER_SNAPSHOT_H
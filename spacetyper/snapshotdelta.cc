@@ -0,0 +1,354 @@
+#include "spacetyper/snapshotdelta.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "core/assert.h"
+
+namespace
+{
+  // shorter zero runs are cheaper to keep in the literal
+  const size_t kMinZeroRun = 3;
+
+  // no snapshot gets close to this, protects against broken sizes
+  const uint64_t kMaxSize = 64 * 1024 * 1024;
+
+  // key and byte count, see snapshot.h
+  const size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+
+  const uint64_t kCopy   = 0;
+  const uint64_t kChange = 1;
+  const uint64_t kNew    = 2;
+
+  struct Record
+  {
+    uint32_t key;
+    // offset of the header and the byte count after it
+    size_t begin;
+    size_t size;
+  };
+
+  typedef std::unordered_map<uint32_t, size_t> RecordIndex;
+
+  void
+  WriteVarint(uint64_t value, std::vector<unsigned char>* out)
+  {
+    while(value >= 0x80)
+    {
+      out->push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    out->push_back(static_cast<unsigned char>(value));
+  }
+
+  bool
+  ReadVarint(
+      const std::vector<unsigned char>& data,
+      size_t*                           position,
+      uint64_t*                         value)
+  {
+    *value = 0;
+    for(int shift = 0; shift < 64 && *position < data.size(); shift += 7)
+    {
+      const unsigned char b = data[(*position)++];
+      *value |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if((b & 0x80) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool
+  ParseRecords(const std::vector<char>& data, std::vector<Record>* records)
+  {
+    records->clear();
+    size_t position = 0;
+    while(position < data.size())
+    {
+      Record   record;
+      uint32_t size = 0;
+      if(data.size() - position < kRecordHeaderSize)
+      {
+        return false;
+      }
+      std::memcpy(&record.key, &data[position], sizeof(record.key));
+      std::memcpy(&size, &data[position + sizeof(record.key)], sizeof(size));
+      if(data.size() - position - kRecordHeaderSize < size)
+      {
+        return false;
+      }
+      record.begin = position;
+      record.size  = size;
+      records->push_back(record);
+      position += kRecordHeaderSize + size;
+    }
+    return true;
+  }
+
+  // a key that shows up twice is matched with its first record
+  void
+  IndexRecords(const std::vector<Record>& records, RecordIndex* index)
+  {
+    index->clear();
+    for(size_t i = 0; i < records.size(); ++i)
+    {
+      index->emplace(records[i].key, i);
+    }
+  }
+
+  const char*
+  GetBytes(const std::vector<char>& data, const Record& record)
+  {
+    return data.data() + record.begin + kRecordHeaderSize;
+  }
+
+  void
+  WriteCopy(
+      const std::vector<Record>&  base,
+      size_t                      start,
+      size_t                      count,
+      std::vector<unsigned char>* delta)
+  {
+    if(count == 0)
+    {
+      return;
+    }
+    WriteVarint(kCopy, delta);
+    WriteVarint(base[start].key, delta);
+    WriteVarint(count, delta);
+  }
+
+  void
+  WriteXor(
+      const char*                 base,
+      const char*                 target,
+      size_t                      size,
+      std::vector<unsigned char>* delta)
+  {
+    const auto xored = [base, target](size_t i) {
+      return static_cast<unsigned char>(target[i] ^ base[i]);
+    };
+
+    size_t position = 0;
+    while(position < size)
+    {
+      const size_t zero_start = position;
+      while(position < size && xored(position) == 0)
+      {
+        ++position;
+      }
+      const size_t zeros = position - zero_start;
+
+      // the literal ends at the first zero run worth its own entry
+      const size_t literal_start = position;
+      size_t       zero_run      = 0;
+      while(position < size && zero_run < kMinZeroRun)
+      {
+        zero_run = xored(position) == 0 ? zero_run + 1 : 0;
+        ++position;
+      }
+      if(zero_run == kMinZeroRun)
+      {
+        position -= zero_run;
+      }
+
+      WriteVarint(zeros, delta);
+      WriteVarint(position - literal_start, delta);
+      for(size_t i = literal_start; i < position; ++i)
+      {
+        delta->push_back(xored(i));
+      }
+    }
+  }
+
+  bool
+  ReadXor(
+      const std::vector<unsigned char>& delta,
+      size_t*                           read,
+      char*                             target,
+      size_t                            size)
+  {
+    uint64_t position = 0;
+    while(position < size)
+    {
+      uint64_t zeros   = 0;
+      uint64_t literal = 0;
+      if(!ReadVarint(delta, read, &zeros) ||
+         !ReadVarint(delta, read, &literal) || zeros > size - position ||
+         literal > size - position - zeros || literal > delta.size() - *read)
+      {
+        return false;
+      }
+      position += zeros;
+      for(uint64_t i = 0; i < literal; ++i)
+      {
+        target[position++] ^= static_cast<char>(delta[(*read)++]);
+      }
+    }
+    return true;
+  }
+}
+
+void
+EncodeSnapshotDelta(
+    const std::vector<char>&    base,
+    const std::vector<char>&    target,
+    std::vector<unsigned char>* delta)
+{
+  ASSERT(delta);
+  delta->clear();
+
+  // both come from the game so they always parse
+  std::vector<Record> base_records;
+  std::vector<Record> target_records;
+  RecordIndex         index;
+  ParseRecords(base, &base_records);
+  ParseRecords(target, &target_records);
+  IndexRecords(base_records, &index);
+
+  // unchanged records that follow each other in both are copied together
+  size_t copy_start = 0;
+  size_t copy_count = 0;
+  for(const Record& t : target_records)
+  {
+    const auto    found = index.find(t.key);
+    const Record* b =
+        found != index.end() ? &base_records[found->second] : nullptr;
+    const bool same_size = b != nullptr && b->size == t.size;
+    if(same_size &&
+       std::equal(
+           GetBytes(base, *b),
+           GetBytes(base, *b) + b->size,
+           GetBytes(target, t)))
+    {
+      if(copy_count == 0 || found->second != copy_start + copy_count)
+      {
+        WriteCopy(base_records, copy_start, copy_count, delta);
+        copy_start = found->second;
+        copy_count = 0;
+      }
+      copy_count += 1;
+      continue;
+    }
+
+    WriteCopy(base_records, copy_start, copy_count, delta);
+    copy_count = 0;
+    if(same_size)
+    {
+      WriteVarint(kChange, delta);
+      WriteVarint(t.key, delta);
+      WriteXor(GetBytes(base, *b), GetBytes(target, t), t.size, delta);
+    }
+    else
+    {
+      WriteVarint(kNew, delta);
+      WriteVarint(t.key, delta);
+      WriteVarint(t.size, delta);
+      delta->insert(
+          delta->end(), GetBytes(target, t), GetBytes(target, t) + t.size);
+    }
+  }
+  WriteCopy(base_records, copy_start, copy_count, delta);
+}
+
+bool
+DecodeSnapshotDelta(
+    const std::vector<char>&          base,
+    const std::vector<unsigned char>& delta,
+    std::vector<char>*                target)
+{
+  ASSERT(target);
+  target->clear();
+
+  std::vector<Record> base_records;
+  RecordIndex         index;
+  if(!ParseRecords(base, &base_records))
+  {
+    return false;
+  }
+  IndexRecords(base_records, &index);
+
+  size_t read = 0;
+  while(read < delta.size())
+  {
+    uint64_t op  = 0;
+    uint64_t key = 0;
+    if(!ReadVarint(delta, &read, &op) || !ReadVarint(delta, &read, &key) ||
+       key > UINT32_MAX)
+    {
+      return false;
+    }
+
+    if(op == kNew)
+    {
+      uint64_t size = 0;
+      if(!ReadVarint(delta, &read, &size) || size > kMaxSize ||
+         size > delta.size() - read)
+      {
+        return false;
+      }
+      const uint32_t header[2] = {static_cast<uint32_t>(key),
+                                  static_cast<uint32_t>(size)};
+      const char*    bytes     = reinterpret_cast<const char*>(header);
+      target->insert(target->end(), bytes, bytes + sizeof(header));
+      target->insert(
+          target->end(), delta.begin() + read, delta.begin() + read + size);
+      read += size;
+    }
+    else
+    {
+      const auto found = index.find(static_cast<uint32_t>(key));
+      if(found == index.end())
+      {
+        return false;
+      }
+      const Record& first = base_records[found->second];
+      if(op == kCopy)
+      {
+        uint64_t count = 0;
+        if(!ReadVarint(delta, &read, &count) || count == 0 ||
+           count > base_records.size() - found->second)
+        {
+          return false;
+        }
+        const Record& last = base_records[found->second + count - 1];
+        target->insert(
+            target->end(),
+            base.begin() + first.begin,
+            base.begin() + last.begin + kRecordHeaderSize + last.size);
+      }
+      else if(op == kChange)
+      {
+        const size_t start = target->size();
+        target->insert(
+            target->end(),
+            base.begin() + first.begin,
+            base.begin() + first.begin + kRecordHeaderSize + first.size);
+        if(!ReadXor(
+               delta,
+               &read,
+               target->data() + start + kRecordHeaderSize,
+               first.size))
+        {
+          return false;
+        }
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    if(target->size() > kMaxSize)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
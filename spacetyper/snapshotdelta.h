@@ -0,0 +1,31 @@
+#ifndef SPACETYPER_SNAPSHOTDELTA_H
+#define SPACETYPER_SNAPSHOTDELTA_H
+
+#include <vector>
+
+// Delta compression of a snapshot against an older one. The records of the
+// two snapshots are matched by key, so things spawning or going away only
+// cost their own records. The target is a list of operations:
+//   0 key count: the base record with the key and the count - 1 records
+//     after it, unchanged
+//   1 key: the base record with the key, with its bytes xored with the base
+//     record, which turns everything that didn't change into zeros, and the
+//     zeros run length encoded as pairs of
+//     varint zero run, varint literal count, literal xored bytes
+//     until the bytes of the record are covered
+//   2 key size bytes: a new record
+// with all numbers as varints. An empty base encodes the whole snapshot.
+void
+EncodeSnapshotDelta(
+    const std::vector<char>&    base,
+    const std::vector<char>&    target,
+    std::vector<unsigned char>* delta);
+
+// false if the delta or the base is broken
+bool
+DecodeSnapshotDelta(
+    const std::vector<char>&          base,
+    const std::vector<unsigned char>& delta,
+    std::vector<char>*                target);
+
+#endif  // SPACETYPER_SNAPSHOTDELTA_H
@@ -0,0 +1,191 @@
+#include "spacetyper/spatialgrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "core/assert.h"
+
+namespace
+{
+  // about two buckets per item so most buckets hold a single cell
+  const std::size_t kMinBuckets = 64;
+
+  std::size_t
+  GetBucketCount(std::size_t entries)
+  {
+    std::size_t count = kMinBuckets;
+    while(count < entries * 2)
+    {
+      count *= 2;
+    }
+    return count;
+  }
+
+  float
+  Clamp(float value, float min, float max)
+  {
+    return std::max(min, std::min(value, max));
+  }
+}
+
+SpatialGrid::SpatialGrid(float cell_size)
+    : cell_size_(cell_size)
+    , bucket_mask_(0)
+    , stamp_(0)
+{
+  ASSERT(cell_size > 0.0f);
+}
+
+void
+SpatialGrid::Clear()
+{
+  items_.clear();
+  entries_.clear();
+  bucket_start_.clear();
+  bucket_mask_ = 0;
+}
+
+int
+SpatialGrid::Add(const vec2f& center, float half_width, float half_height)
+{
+  ASSERT(half_width >= 0.0f && half_height >= 0.0f);
+  Item item;
+  item.left   = center.x - half_width;
+  item.right  = center.x + half_width;
+  item.bottom = center.y - half_height;
+  item.top    = center.y + half_height;
+  items_.push_back(item);
+  return items_.size() - 1;
+}
+
+void
+SpatialGrid::Build()
+{
+  // counting sort of the (cell, item) pairs on the bucket, first count how
+  // many go in each bucket and then fill them in
+  std::size_t pairs = 0;
+  for(const Item& item : items_)
+  {
+    pairs += (GetCell(item.right) - GetCell(item.left) + 1) *
+             (GetCell(item.top) - GetCell(item.bottom) + 1);
+  }
+  const std::size_t bucket_count = GetBucketCount(pairs);
+  bucket_mask_                   = bucket_count - 1;
+  bucket_start_.assign(bucket_count + 1, 0);
+  entries_.resize(pairs);
+
+  const auto for_each_cell = [this](const Item& item, int id, bool fill) {
+    for(int y = GetCell(item.bottom); y <= GetCell(item.top); ++y)
+    {
+      for(int x = GetCell(item.left); x <= GetCell(item.right); ++x)
+      {
+        const std::size_t bucket = GetBucket(x, y);
+        if(fill)
+        {
+          // the starts are moved one bucket ahead while filling and end up
+          // where they belong
+          entries_[bucket_start_[bucket + 1]++] = id;
+        }
+        else
+        {
+          bucket_start_[bucket + 1] += 1;
+        }
+      }
+    }
+  };
+
+  const int count = items_.size();
+  for(int id = 0; id < count; ++id)
+  {
+    for_each_cell(items_[id], id, false);
+  }
+  // exclusive prefix sum, shifted one bucket so the fill can use it
+  int sum = 0;
+  for(std::size_t b = 1; b <= bucket_count; ++b)
+  {
+    const int size   = bucket_start_[b];
+    bucket_start_[b] = sum;
+    sum += size;
+  }
+  for(int id = 0; id < count; ++id)
+  {
+    for_each_cell(items_[id], id, true);
+  }
+
+  stamps_.assign(items_.size(), 0);
+  stamp_ = 0;
+}
+
+int
+SpatialGrid::GetCount() const
+{
+  return items_.size();
+}
+
+void
+SpatialGrid::Query(
+    const std::vector<GridCircle>& circles, std::vector<GridHit>* hits)
+{
+  ASSERT(hits);
+  if(items_.empty())
+  {
+    return;
+  }
+  ASSERT(bucket_start_.size() == bucket_mask_ + 2);
+
+  const int query_count = circles.size();
+  for(int query = 0; query < query_count; ++query)
+  {
+    const GridCircle& circle = circles[query];
+    stamp_ += 1;
+
+    const float radius_sq = circle.radius * circle.radius;
+    const int   left      = GetCell(circle.center.x - circle.radius);
+    const int   right     = GetCell(circle.center.x + circle.radius);
+    const int   bottom    = GetCell(circle.center.y - circle.radius);
+    const int   top       = GetCell(circle.center.y + circle.radius);
+    for(int y = bottom; y <= top; ++y)
+    {
+      for(int x = left; x <= right; ++x)
+      {
+        const std::size_t bucket = GetBucket(x, y);
+        for(int e = bucket_start_[bucket]; e < bucket_start_[bucket + 1]; ++e)
+        {
+          // other cells may share the bucket, the exact test sorts them out
+          const int id = entries_[e];
+          if(stamps_[id] == stamp_)
+          {
+            continue;
+          }
+          stamps_[id] = stamp_;
+
+          const Item& item = items_[id];
+          const float dx =
+              Clamp(circle.center.x, item.left, item.right) - circle.center.x;
+          const float dy =
+              Clamp(circle.center.y, item.bottom, item.top) - circle.center.y;
+          if(dx * dx + dy * dy <= radius_sq)
+          {
+            hits->push_back(GridHit{query, id});
+          }
+        }
+      }
+    }
+  }
+}
+
+int
+SpatialGrid::GetCell(float position) const
+{
+  return static_cast<int>(std::floor(position / cell_size_));
+}
+
+std::size_t
+SpatialGrid::GetBucket(int x, int y) const
+{
+  // two large primes, the usual spatial hash
+  const uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^
+                        (static_cast<uint32_t>(y) * 19349663u);
+  return hash & bucket_mask_;
+}
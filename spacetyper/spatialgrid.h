@@ -0,0 +1,80 @@
+#ifndef SPACETYPER_SPATIALGRID_H
+#define SPACETYPER_SPATIALGRID_H
+
+#include <cstddef>
+#include <vector>
+
+#include "core/vec2.h"
+
+struct GridCircle
+{
+  vec2f center;
+  float radius;
+};
+
+// circle query overlaps item
+struct GridHit
+{
+  int query;
+  int item;
+};
+
+// Broad phase for the collisions. The items are boxes that are put in
+// uniform cells hashed into buckets, so the world has no bounds and the
+// memory only depends on the item count. The grid is rebuilt every frame in
+// linear time and a query only looks at the cells it covers, so the cost
+// stays close to linear in the number of items and queries.
+class SpatialGrid
+{
+ public:
+  // cells about the size of the items keep both the cells per item and the
+  // items per cell low
+  explicit SpatialGrid(float cell_size);
+
+  void
+  Clear();
+
+  // the ids count from 0 after a Clear
+  int
+  Add(const vec2f& center, float half_width, float half_height);
+
+  // sorts the added items into the cells, queries are only valid after this
+  void
+  Build();
+
+  int
+  GetCount() const;
+
+  // appends every item that overlaps each circle, in query order and every
+  // item at most once per query
+  void
+  Query(const std::vector<GridCircle>& circles, std::vector<GridHit>* hits);
+
+ private:
+  struct Item
+  {
+    float left;
+    float right;
+    float bottom;
+    float top;
+  };
+
+  int
+  GetCell(float position) const;
+
+  std::size_t
+  GetBucket(int x, int y) const;
+
+  float             cell_size_;
+  std::vector<Item> items_;
+  std::size_t       bucket_mask_;
+  // the items of bucket b are entries_[bucket_start_[b]] until the start of
+  // the next bucket
+  std::vector<int> bucket_start_;
+  std::vector<int> entries_;
+  // an item found in several cells is only tested once per query
+  std::vector<unsigned int> stamps_;
+  unsigned int              stamp_;
+};
+
+#endif  // SPACETYPER_SPATIALGRID_H
@@ -0,0 +1,623 @@
+#include "spacetyper/spectator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "core/assert.h"
+
+#include "spacetyper/snapshotdelta.h"
+
+#ifdef _WIN32
+
+SpectatorServer::SpectatorServer()
+    : socket_(-1)
+    , running_(false)
+    , client_count_(0)
+    , bytes_sent_(0)
+    , published_tick_(0)
+    , taken_tick_(0)
+{
+}
+
+SpectatorServer::~SpectatorServer()
+{
+}
+
+bool
+SpectatorServer::Start(int, std::string* error)
+{
+  *error = "Spectating is only supported on posix systems";
+  return false;
+}
+
+void
+SpectatorServer::Stop()
+{
+}
+
+void
+SpectatorServer::Publish(std::vector<char>*)
+{
+}
+
+SpectatorClient::SpectatorClient()
+    : socket_(-1)
+    , out_sent_(0)
+    , bytes_received_(0)
+{
+}
+
+SpectatorClient::~SpectatorClient()
+{
+}
+
+bool
+SpectatorClient::Connect(int, std::string* error)
+{
+  *error = "Spectating is only supported on posix systems";
+  return false;
+}
+
+void
+SpectatorClient::Disconnect()
+{
+}
+
+bool
+SpectatorClient::Poll(std::vector<char>*)
+{
+  return false;
+}
+
+#else
+
+namespace
+{
+  // deltas can only be made against snapshots still in the history, a
+  // client that falls further behind gets a full snapshot
+  const size_t kHistorySize = 64;
+
+  // a tick is 16ms, this is the most it adds to the latency
+  const int kPollTimeout = 2;
+
+  const size_t kHeaderSize = sizeof(uint32_t);
+
+  // tick and base tick in front of the delta
+  const int64_t kFrameHeaderSize = 2 * sizeof(uint32_t);
+
+  // nothing sent either way is close to this
+  const uint32_t kMaxMessageSize = 64 * 1024 * 1024;
+
+  void
+  AppendUint(std::vector<unsigned char>* out, uint32_t value)
+  {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    out->insert(out->end(), bytes, bytes + sizeof(value));
+  }
+
+  uint32_t
+  ReadUint(const unsigned char* in)
+  {
+    uint32_t value = 0;
+    std::memcpy(&value, in, sizeof(value));
+    return value;
+  }
+
+  // returns the size of the first complete message, 0 if it hasn't arrived
+  // and -1 if the size is broken
+  int64_t
+  GetMessageSize(const std::vector<unsigned char>& in, size_t position)
+  {
+    if(in.size() - position < kHeaderSize)
+    {
+      return 0;
+    }
+    const uint32_t size = ReadUint(in.data() + position);
+    if(size > kMaxMessageSize)
+    {
+      return -1;
+    }
+    return in.size() - position - kHeaderSize >= size ? size : 0;
+  }
+
+  bool
+  SetupSocket(int socket)
+  {
+    const int flags = fcntl(socket, F_GETFL, 0);
+    const int yes   = 1;
+#ifdef SO_NOSIGPIPE
+    // osx has no MSG_NOSIGNAL
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0 &&
+           setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes)) ==
+               0;
+  }
+
+  sockaddr_in
+  GetLoopbackAddress(int port)
+  {
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+  }
+
+  // false if the connection is gone
+  bool
+  ReceiveAll(int socket, std::vector<unsigned char>* in, uint64_t* received)
+  {
+    unsigned char buffer[64 * 1024];
+    while(true)
+    {
+      const ssize_t result = recv(socket, buffer, sizeof(buffer), 0);
+      if(result > 0)
+      {
+        in->insert(in->end(), buffer, buffer + result);
+        if(received != nullptr)
+        {
+          *received += result;
+        }
+      }
+      else if(result == 0)
+      {
+        return false;
+      }
+      else
+      {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+      }
+    }
+  }
+
+  // false if the connection is gone
+  bool
+  SendAll(int socket, std::vector<unsigned char>* out, size_t* sent)
+  {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while(*sent < out->size())
+    {
+      const ssize_t result =
+          send(socket, out->data() + *sent, out->size() - *sent, flags);
+      if(result < 0)
+      {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+      }
+      *sent += result;
+    }
+    out->clear();
+    *sent = 0;
+    return true;
+  }
+}
+
+SpectatorServer::SpectatorServer()
+    : socket_(-1)
+    , running_(false)
+    , client_count_(0)
+    , bytes_sent_(0)
+    , published_tick_(0)
+    , taken_tick_(0)
+{
+}
+
+SpectatorServer::~SpectatorServer()
+{
+  Stop();
+}
+
+bool
+SpectatorServer::Start(int port, std::string* error)
+{
+  ASSERT(error);
+  ASSERT(socket_ == -1);
+
+  socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  if(socket_ == -1)
+  {
+    *error = std::string{"Failed to create spectator socket: "} +
+             std::strerror(errno);
+    return false;
+  }
+
+  const int   yes     = 1;
+  sockaddr_in address = GetLoopbackAddress(port);
+  setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  if(bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+         0 ||
+     listen(socket_, 4) != 0 ||
+     fcntl(socket_, F_SETFL, fcntl(socket_, F_GETFL, 0) | O_NONBLOCK) != 0)
+  {
+    *error = "Failed to listen on port " + std::to_string(port) + ": " +
+             std::strerror(errno);
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  running_ = true;
+  thread_  = std::thread{&SpectatorServer::Run, this};
+  return true;
+}
+
+void
+SpectatorServer::Stop()
+{
+  if(thread_.joinable())
+  {
+    running_ = false;
+    thread_.join();
+  }
+  for(Client& client : clients_)
+  {
+    close(client.socket);
+  }
+  clients_.clear();
+  client_count_ = 0;
+  if(socket_ != -1)
+  {
+    close(socket_);
+    socket_ = -1;
+  }
+}
+
+void
+SpectatorServer::Publish(std::vector<char>* snapshot)
+{
+  ASSERT(snapshot);
+  std::lock_guard<std::mutex> lock(mutex_);
+  published_.swap(*snapshot);
+  published_tick_ += 1;
+}
+
+void
+SpectatorServer::Run()
+{
+  std::vector<pollfd> fds;
+  while(running_)
+  {
+    fds.clear();
+    fds.push_back(pollfd{socket_, POLLIN, 0});
+    for(const Client& client : clients_)
+    {
+      const short events = client.out.empty() ? POLLIN : POLLIN | POLLOUT;
+      fds.push_back(pollfd{client.socket, events, 0});
+    }
+    poll(fds.data(), fds.size(), kPollTimeout);
+
+    int accepted = -1;
+    while((accepted = accept(socket_, nullptr, nullptr)) != -1)
+    {
+      if(SetupSocket(accepted))
+      {
+        clients_.push_back(Client{accepted, 0, 0, {}, {}, 0});
+      }
+      else
+      {
+        close(accepted);
+      }
+    }
+
+    TakePublished();
+
+    for(size_t i = 0; i < clients_.size();)
+    {
+      Client& client = clients_[i];
+      bool    ok     = Receive(&client);
+
+      // a client gets the next tick once it has read the last one, so a
+      // slow client skips ticks instead of queueing them
+      if(ok && client.out.empty() && !history_.empty() &&
+         history_.back().tick != client.sent)
+      {
+        const uint32_t base =
+            FindSnapshot(client.acked) != nullptr ? client.acked : 0;
+        const std::vector<unsigned char>& delta = GetDelta(base);
+        AppendUint(&client.out, kFrameHeaderSize + delta.size());
+        AppendUint(&client.out, history_.back().tick);
+        AppendUint(&client.out, base);
+        client.out.insert(client.out.end(), delta.begin(), delta.end());
+        client.sent = history_.back().tick;
+        bytes_sent_.fetch_add(client.out.size(), std::memory_order_relaxed);
+      }
+
+      ok = ok && Flush(&client);
+      if(ok)
+      {
+        ++i;
+      }
+      else
+      {
+        close(client.socket);
+        clients_.erase(clients_.begin() + i);
+      }
+    }
+    client_count_ = static_cast<int>(clients_.size());
+  }
+}
+
+void
+SpectatorServer::TakePublished()
+{
+  Frame frame;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(published_tick_ == taken_tick_)
+    {
+      return;
+    }
+    // the game thread gets an empty buffer back, it can't be reused since
+    // the history keeps it for the deltas
+    frame.tick = published_tick_;
+    frame.snapshot.swap(published_);
+    taken_tick_ = published_tick_;
+  }
+
+  history_.push_back(std::move(frame));
+  if(history_.size() > kHistorySize)
+  {
+    history_.pop_front();
+  }
+  deltas_.clear();
+}
+
+const std::vector<char>*
+SpectatorServer::FindSnapshot(uint32_t tick) const
+{
+  for(const Frame& frame : history_)
+  {
+    if(frame.tick == tick)
+    {
+      return &frame.snapshot;
+    }
+  }
+  return nullptr;
+}
+
+const std::vector<unsigned char>&
+SpectatorServer::GetDelta(uint32_t base)
+{
+  for(const auto& delta : deltas_)
+  {
+    if(delta.first == base)
+    {
+      return delta.second;
+    }
+  }
+
+  static const std::vector<char> kEmpty;
+  const std::vector<char>*       base_snapshot = FindSnapshot(base);
+  deltas_.emplace_back(base, std::vector<unsigned char>{});
+  EncodeSnapshotDelta(
+      base_snapshot != nullptr ? *base_snapshot : kEmpty,
+      history_.back().snapshot,
+      &deltas_.back().second);
+  return deltas_.back().second;
+}
+
+bool
+SpectatorServer::Receive(Client* client)
+{
+  if(!ReceiveAll(client->socket, &client->in, nullptr))
+  {
+    return false;
+  }
+
+  size_t position = 0;
+  while(true)
+  {
+    const int64_t size = GetMessageSize(client->in, position);
+    if(size < 0 || (size > 0 && size != sizeof(uint32_t)))
+    {
+      return false;
+    }
+    if(size == 0)
+    {
+      break;
+    }
+    client->acked = ReadUint(client->in.data() + position + kHeaderSize);
+    position += kHeaderSize + size;
+  }
+  client->in.erase(client->in.begin(), client->in.begin() + position);
+  return true;
+}
+
+bool
+SpectatorServer::Flush(Client* client)
+{
+  return SendAll(client->socket, &client->out, &client->out_sent);
+}
+
+SpectatorClient::SpectatorClient()
+    : socket_(-1)
+    , out_sent_(0)
+    , bytes_received_(0)
+{
+}
+
+SpectatorClient::~SpectatorClient()
+{
+  Disconnect();
+}
+
+bool
+SpectatorClient::Connect(int port, std::string* error)
+{
+  ASSERT(error);
+  ASSERT(socket_ == -1);
+
+  socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  if(socket_ == -1)
+  {
+    *error = std::string{"Failed to create spectator socket: "} +
+             std::strerror(errno);
+    return false;
+  }
+
+  sockaddr_in address = GetLoopbackAddress(port);
+  if(connect(
+         socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+         0 ||
+     !SetupSocket(socket_))
+  {
+    *error = "Failed to connect to port " + std::to_string(port) + ": " +
+             std::strerror(errno);
+    Disconnect();
+    return false;
+  }
+
+  return true;
+}
+
+void
+SpectatorClient::Disconnect()
+{
+  if(socket_ != -1)
+  {
+    close(socket_);
+    socket_ = -1;
+  }
+  in_.clear();
+  out_.clear();
+  out_sent_ = 0;
+  history_.clear();
+}
+
+bool
+SpectatorClient::Poll(std::vector<char>* snapshot)
+{
+  ASSERT(snapshot);
+  if(!IsConnected())
+  {
+    return false;
+  }
+
+  if(!ReceiveAll(socket_, &in_, &bytes_received_))
+  {
+    Disconnect();
+    return false;
+  }
+
+  bool   decoded  = false;
+  size_t position = 0;
+  while(true)
+  {
+    const int64_t size = GetMessageSize(in_, position);
+    if(size < 0 || (size > 0 && size < kFrameHeaderSize))
+    {
+      Disconnect();
+      return false;
+    }
+    if(size == 0)
+    {
+      break;
+    }
+    decoded =
+        Decode(in_.data() + position + kHeaderSize, size) || decoded;
+    position += kHeaderSize + size;
+  }
+  in_.erase(in_.begin(), in_.begin() + position);
+
+  if(decoded)
+  {
+    Acknowledge(history_.back().tick);
+    *snapshot = history_.back().snapshot;
+  }
+
+  if(!SendAll(socket_, &out_, &out_sent_))
+  {
+    Disconnect();
+  }
+
+  return decoded;
+}
+
+bool
+SpectatorClient::Decode(const unsigned char* message, size_t size)
+{
+  const uint32_t tick = ReadUint(message);
+  const uint32_t base = ReadUint(message + sizeof(uint32_t));
+
+  static const std::vector<char> kEmpty;
+  const std::vector<char>*       base_snapshot = &kEmpty;
+  if(base != 0)
+  {
+    base_snapshot = nullptr;
+    for(const Frame& frame : history_)
+    {
+      if(frame.tick == base)
+      {
+        base_snapshot = &frame.snapshot;
+      }
+    }
+  }
+
+  const std::vector<unsigned char> delta(
+      message + kFrameHeaderSize, message + size);
+  Frame                            frame;
+  frame.tick = tick;
+  if(base_snapshot == nullptr ||
+     !DecodeSnapshotDelta(*base_snapshot, delta, &frame.snapshot))
+  {
+    // start over from a full snapshot
+    Acknowledge(0);
+    return false;
+  }
+
+  history_.push_back(std::move(frame));
+  if(history_.size() > kHistorySize)
+  {
+    history_.pop_front();
+  }
+  return true;
+}
+
+void
+SpectatorClient::Acknowledge(uint32_t tick)
+{
+  AppendUint(&out_, sizeof(uint32_t));
+  AppendUint(&out_, tick);
+}
+
+#endif
+
+int
+SpectatorServer::GetClientCount() const
+{
+  return client_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t
+SpectatorServer::GetBytesSent() const
+{
+  return bytes_sent_.load(std::memory_order_relaxed);
+}
+
+bool
+SpectatorClient::IsConnected() const
+{
+  return socket_ != -1;
+}
+
+uint64_t
+SpectatorClient::GetBytesReceived() const
+{
+  return bytes_received_;
+}
@@ -0,0 +1,143 @@
+#ifndef SPACETYPER_SPECTATOR_H
+#define SPACETYPER_SPECTATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Mirrors a running session to spectators over tcp on the loopback
+// interface. The server sends a view snapshot of every tick delta encoded
+// against the last snapshot the client acknowledged, the client restores
+// them into a session it renders without updating. Snapshots are
+// native endian so both ends must be the same build, on the same machine.
+//
+// Every message is a native uint32 byte count followed by the payload:
+//   server: uint32 tick, uint32 base tick (0 for none), delta
+//   client: uint32 acknowledged tick (0 asks for a full snapshot)
+class SpectatorServer
+{
+ public:
+  SpectatorServer();
+  ~SpectatorServer();
+
+  bool
+  Start(int port, std::string* error);
+
+  void
+  Stop();
+
+  // game thread, takes the snapshot and leaves an old buffer to reuse.
+  // Never waits on the clients, a slow client skips ticks
+  void
+  Publish(std::vector<char>* snapshot);
+
+  int
+  GetClientCount() const;
+
+  uint64_t
+  GetBytesSent() const;
+
+ private:
+  struct Client
+  {
+    int                        socket;
+    uint32_t                   acked;
+    uint32_t                   sent;
+    std::vector<unsigned char> in;
+    std::vector<unsigned char> out;
+    size_t                     out_sent;
+  };
+
+  struct Frame
+  {
+    uint32_t          tick;
+    std::vector<char> snapshot;
+  };
+
+  void
+  Run();
+
+  void
+  TakePublished();
+
+  const std::vector<char>*
+  FindSnapshot(uint32_t tick) const;
+
+  const std::vector<unsigned char>&
+  GetDelta(uint32_t base);
+
+  bool
+  Receive(Client* client);
+
+  bool
+  Flush(Client* client);
+
+  int                   socket_;
+  std::atomic<bool>     running_;
+  std::atomic<int>      client_count_;
+  std::atomic<uint64_t> bytes_sent_;
+  std::thread           thread_;
+
+  // shared with the game thread
+  std::mutex        mutex_;
+  std::vector<char> published_;
+  uint32_t          published_tick_;
+  uint32_t          taken_tick_;
+
+  // server thread only, newest last
+  std::deque<Frame>   history_;
+  std::vector<Client> clients_;
+  // clients that acknowledged the same tick share the encoded delta
+  std::vector<std::pair<uint32_t, std::vector<unsigned char>>> deltas_;
+};
+
+class SpectatorClient
+{
+ public:
+  SpectatorClient();
+  ~SpectatorClient();
+
+  bool
+  Connect(int port, std::string* error);
+
+  void
+  Disconnect();
+
+  bool
+  IsConnected() const;
+
+  // reads what has arrived without waiting, true if a newer snapshot was
+  // decoded into snapshot
+  bool
+  Poll(std::vector<char>* snapshot);
+
+  uint64_t
+  GetBytesReceived() const;
+
+ private:
+  struct Frame
+  {
+    uint32_t          tick;
+    std::vector<char> snapshot;
+  };
+
+  // false if the message can't be decoded
+  bool
+  Decode(const unsigned char* message, size_t size);
+
+  void
+  Acknowledge(uint32_t tick);
+
+  int                        socket_;
+  std::vector<unsigned char> in_;
+  std::vector<unsigned char> out_;
+  size_t                     out_sent_;
+  std::deque<Frame>          history_;
+  uint64_t                   bytes_received_;
+};
+
+#endif  // SPACETYPER_SPECTATOR_H
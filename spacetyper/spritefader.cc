@@ -1,14 +1,42 @@
 #include "spacetyper/spritefader.h"
 
 #include <algorithm>
+#include <random>
 
 #include "render/sprite.h"
 
-SpriteFader::SpriteFader(Layer* layer)
-    : generator_(std::random_device()())
+#include "spacetyper/alloctracker.h"
+#include "spacetyper/culledlayer.h"
+#include "spacetyper/qualitygovernor.h"
+#include "spacetyper/snapshot.h"
+
+SpriteFader::SpriteFader(
+    CulledLayer* layer, TimerWheel* timers, unsigned int seed)
+    : generator_(seed)
     , layer_(layer)
+    , timers_(timers)
+    , next_id_(0)
+    , emission_(1.0f)
+    , lifetime_(1.0f)
+    , budget_(EffectsQuality().particle_budget)
+    , skipped_(0)
 {
   ASSERT(layer);
+  ASSERT(timers);
+}
+
+SpriteFader::~SpriteFader()
+{
+  Clear();
+}
+
+void
+SpriteFader::SetQuality(const EffectsQuality& quality)
+{
+  ASSERT(quality.particle_budget > 0);
+  emission_ = quality.emission;
+  lifetime_ = quality.lifetime;
+  budget_   = quality.particle_budget;
 }
 
 void
@@ -23,41 +51,190 @@ SpriteFader::AddRandom(const vec2f& pos, float time, float width, float height)
   ASSERT(time > 0.0f);
   ASSERT(!textures_.empty());
 
+  // start thinning out at half the budget so mass explosions fade into the
+  // limit instead of hitting it
+  const size_t count = GetCount();
+  const float  fill  = static_cast<float>(count) / budget_;
+  const float  chance =
+      emission_ * std::max(0.0f, std::min((1.0f - fill) * 2.0f, 1.0f));
+  if(count >= budget_ ||
+     (chance < 1.0f &&
+      std::uniform_real_distribution<float>(0.0f, 1.0f)(generator_) >= chance))
+  {
+    skipped_ += 1;
+    return;
+  }
+  time *= lifetime_;
+
   const float dx =
       std::uniform_real_distribution<float>(-width / 2, width / 2)(generator_);
   const float dy = std::uniform_real_distribution<float>(
       -height / 2, height / 2)(generator_);
 
-  auto t = textures_[std::uniform_int_distribution<size_t>(
-      0, textures_.size() - 1)(generator_)];
+  const size_t texture = std::uniform_int_distribution<size_t>(
+      0, textures_.size() - 1)(generator_);
+
+  Spawn(next_id_, texture, pos + vec2f(dx, dy), time, time / 2);
+  next_id_ = (next_id_ + 1) & kMaxRecordId;
+}
+
+void
+SpriteFader::Update(float dt)
+{
+  const ScopedAllocationTag alloc_tag(AllocationScope::SpriteFader);
+  if(!expired_.empty())
+  {
+    std::vector<Sprite*> removed;
+    removed.reserve(expired_.size());
+    for(const FadingSprite& sp : expired_)
+    {
+      removed.push_back(sp.sprite.get());
+    }
+    layer_->Remove(removed);
+    expired_.clear();
+  }
+
+  const double now = timers_->GetTime();
+  for(FadingSprite& sp : fading_)
+  {
+    const float a = (sp.end - now) / sp.fade;
+    sp.alpha      = std::max(0.0f, std::min(a, 1.0f));
+    sp.sprite->SetAlpha(sp.alpha);
+  }
+}
+
+int
+SpriteFader::GetCount() const
+{
+  return waiting_.size() + fading_.size();
+}
+
+int
+SpriteFader::GetSkipped() const
+{
+  return skipped_;
+}
 
+void
+SpriteFader::Spawn(
+    uint32_t     id,
+    std::size_t  texture,
+    const vec2f& pos,
+    float        time,
+    float        fade)
+{
+  const ScopedAllocationTag alloc_tag(AllocationScope::SpriteFader);
   FadingSprite sp;
-  sp.time  = time;
-  sp.start = time / 2;
-  sp.sprite.reset(new Sprite(t, pos + vec2f(dx, dy)));
+  sp.id      = id;
+  sp.end     = timers_->GetTime() + time;
+  sp.fade    = fade;
+  sp.texture = texture;
+  sp.alpha   = 1.0f;
+  sp.timer   = 0;
+  sp.sprite.reset(new Sprite(textures_[texture], pos));
 
-  layer_->Add(sp.sprite.get());
-  sprites_.push_back(sp);
+  // the list nodes don't move so the layer can point to the alpha
+  if(time > fade)
+  {
+    auto it   = waiting_.insert(waiting_.end(), sp);
+    it->timer = timers_->Schedule(
+        time - fade, [this, it]() { StartFade(it); });
+    layer_->Add(it->sprite.get(), &it->alpha);
+  }
+  else
+  {
+    auto it   = fading_.insert(fading_.end(), sp);
+    it->alpha = std::max(0.0f, std::min(time / fade, 1.0f));
+    it->sprite->SetAlpha(it->alpha);
+    it->timer = timers_->Schedule(time, [this, it]() { Expire(it); });
+    layer_->Add(it->sprite.get(), &it->alpha);
+  }
 }
 
 void
-SpriteFader::Update(float dt)
+SpriteFader::StartFade(Sprites::iterator sprite)
+{
+  fading_.splice(fading_.end(), waiting_, sprite);
+  sprite->timer = timers_->Schedule(
+      sprite->end - timers_->GetTime(), [this, sprite]() { Expire(sprite); });
+}
+
+void
+SpriteFader::Expire(Sprites::iterator sprite)
+{
+  expired_.splice(expired_.end(), fading_, sprite);
+}
+
+void
+SpriteFader::Clear()
+{
+  std::vector<Sprite*> removed;
+  removed.reserve(GetCount());
+  for(Sprites* list : {&waiting_, &fading_})
+  {
+    for(const FadingSprite& sp : *list)
+    {
+      timers_->Cancel(sp.timer);
+      removed.push_back(sp.sprite.get());
+    }
+    list->clear();
+  }
+  // expired sprites are still in the layer until the next update
+  for(const FadingSprite& sp : expired_)
+  {
+    removed.push_back(sp.sprite.get());
+  }
+  expired_.clear();
+  layer_->Remove(removed);
+}
+
+void
+SpriteFader::Save(SnapshotWriter* writer) const
 {
-  for(FadingSprite& sp : sprites_)
+  // the end times are absolute so a sprite's record only changes when it
+  // comes or goes
+  writer->BeginRecord(SnapshotRecord::Particles, 0);
+  writer->WriteGenerator(generator_);
+  writer->WriteInt(static_cast<int>(next_id_));
+  writer->WriteDouble(timers_->GetTime());
+  writer->EndRecord();
+  for(const Sprites* list : {&waiting_, &fading_})
   {
-    sp.time -= dt;
-    const float a = sp.time / sp.start;
-    sp.sprite->SetAlpha(std::max(0.0f, std::min(a, 1.0f)));
-    if(sp.time <= 0.0f)
+    for(const FadingSprite& sp : *list)
     {
-      layer_->Remove(sp.sprite.get());
+      writer->BeginRecord(SnapshotRecord::Particle, sp.id);
+      writer->WriteInt(sp.texture);
+      writer->WriteVec2(sp.sprite->GetPosition());
+      writer->WriteDouble(sp.end);
+      writer->WriteFloat(sp.fade);
+      writer->EndRecord();
     }
   }
+}
+
+void
+SpriteFader::Restore(SnapshotReader* reader)
+{
+  reader->BeginRecord(SnapshotRecord::Particles);
+  reader->ReadGenerator(&generator_);
+  next_id_         = static_cast<uint32_t>(reader->ReadInt()) & kMaxRecordId;
+  const double now = reader->ReadDouble();
+  reader->EndRecord();
+  Clear();
 
-  sprites_.erase(
-      std::remove_if(
-          sprites_.begin(),
-          sprites_.end(),
-          [](const FadingSprite& sp) { return sp.time <= 0.0f; }),
-      sprites_.end());
+  while(reader->PeekRecord() == SnapshotRecord::Particle)
+  {
+    const uint32_t id      = reader->BeginRecord(SnapshotRecord::Particle);
+    const int      texture = reader->ReadIndex(textures_.size());
+    const vec2f    pos     = reader->ReadVec2();
+    const double   end     = reader->ReadDouble();
+    const float    fade    = reader->ReadFloat();
+    reader->EndRecord();
+    if(texture < 0 || fade <= 0.0f)
+    {
+      reader->Fail();
+      return;
+    }
+    Spawn(id, texture, pos, std::max(0.0, end - now), fade);
+  }
 }
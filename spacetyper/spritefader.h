@@ -1,39 +1,84 @@
 #ifndef SPACETYPER_SPRITEFADER_H
 #define SPACETYPER_SPRITEFADER_H
 
+#include <cstdint>
+#include <list>
 #include <memory>
-#include <random>
 #include <vector>
 
 #include "core/vec2.h"
 
+#include "spacetyper/pcg32.h"
+#include "spacetyper/timerwheel.h"
+
 class Texture2d;
-class Layer;
+class CulledLayer;
 class Sprite;
+class SnapshotReader;
+class SnapshotWriter;
+struct EffectsQuality;
 
+// full alpha until the last fade seconds of its life
 struct FadingSprite {
-  float time;
-  float start;
+  // stays the same for the life of the sprite, snapshots are keyed by it
+  uint32_t id;
+  double end;
+  float fade;
+  std::size_t texture;
   std::shared_ptr<Sprite> sprite;
+  // the layer reads it when recording the sprite
+  float alpha;
+  TimerId timer;
 };
 
 class SpriteFader {
 public:
-  explicit SpriteFader(Layer *layer);
+  SpriteFader(CulledLayer *layer, TimerWheel *timers, unsigned int seed);
+  ~SpriteFader();
   void RegisterTexture(std::shared_ptr<Texture2d> t);
+
+  // emission and lifetime scale every new sprite, the particle budget is
+  // approached gradually by spawning fewer sprites the fuller it gets
+  void SetQuality(const EffectsQuality &quality);
   void AddRandom(const vec2f &pos, float time, float width, float height);
 
+  // only the sprites that are fading out are touched
   void Update(float dt);
 
+  int GetCount() const;
+  // sprites not spawned because of the quality settings
+  int GetSkipped() const;
+
+  void Save(SnapshotWriter *writer) const;
+  void Restore(SnapshotReader *reader);
+
 private:
-  mutable std::mt19937 generator_;
-  Layer *layer_;
+  typedef std::list<FadingSprite> Sprites;
+
+  void Spawn(uint32_t id, std::size_t texture, const vec2f &pos, float time,
+             float fade);
+  void StartFade(Sprites::iterator sprite);
+  void Expire(Sprites::iterator sprite);
+  void Clear();
+
+  Pcg32 generator_;
+  CulledLayer *layer_;
+  TimerWheel *timers_;
 
   typedef std::vector<std::shared_ptr<Texture2d>> Textures;
   Textures textures_;
 
-  typedef std::vector<FadingSprite> Sprites;
-  Sprites sprites_;
+  // the timers move sprites from waiting to fading and then to expired,
+  // expired sprites leave the layer together in the next update
+  Sprites waiting_;
+  Sprites fading_;
+  Sprites expired_;
+
+  uint32_t next_id_;
+  float emission_;
+  float lifetime_;
+  size_t budget_;
+  int skipped_;
 };
 
 #endif // SPACETYPER_SPRITEFADER_H
@@ -0,0 +1,74 @@
+#ifndef SPACETYPER_SPSCQUEUE_H
+#define SPACETYPER_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue from one producer thread to one consumer thread.
+// Neither side ever waits, Push fails when the queue is full and Pop fails
+// when it's empty. Each side caches the other side's index so the shared
+// cache lines are only touched when the cached value runs out.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+ public:
+  static_assert(
+      Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+      "capacity must be a power of two");
+
+  SpscQueue()
+      : head_(0)
+      , cached_tail_(0)
+      , tail_(0)
+      , cached_head_(0)
+  {
+  }
+
+  // producer side
+  bool
+  Push(const T& item)
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if(head - cached_tail_ == Capacity)
+    {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if(head - cached_tail_ == Capacity)
+      {
+        return false;
+      }
+    }
+    items_[head & kMask] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  bool
+  Pop(T* item)
+  {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail == cached_head_)
+    {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if(tail == cached_head_)
+      {
+        return false;
+      }
+    }
+    *item = items_[tail & kMask];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static const std::size_t kMask = Capacity - 1;
+
+  // producer and consumer data on separate cache lines
+  alignas(64) std::atomic<std::size_t> head_;
+  std::size_t cached_tail_;
+  alignas(64) std::atomic<std::size_t> tail_;
+  std::size_t cached_head_;
+  alignas(64) T items_[Capacity];
+};
+
+#endif  // SPACETYPER_SPSCQUEUE_H
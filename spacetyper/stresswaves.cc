@@ -0,0 +1,55 @@
+#include "spacetyper/stresswaves.h"
+
+#include "spacetyper/enemies.h"
+#include "spacetyper/gamesession.h"
+
+namespace
+{
+  // wave n is n times the size of the first and spawns n times as fast, so
+  // every wave takes as long to spawn while the enemies grow quadratically
+  const int   kFirstWaveSize     = 5;
+  const float kFirstWaveInterval = 1.0f;
+
+  const float kFirstTypingSpeed = 10.0f;
+  const float kTypingSpeedRamp  = 2.0f;
+}
+
+StressWaves::StressWaves()
+    : wave_(0)
+    , time_left_(0.0f)
+    , typer_(1, kFirstTypingSpeed)
+{
+}
+
+void
+StressWaves::Update(GameSession* session, float dt)
+{
+  time_left_ -= dt;
+  if(time_left_ <= 0.0f)
+  {
+    StartWave(session);
+  }
+  typer_(0, session, dt);
+}
+
+int
+StressWaves::GetWave() const
+{
+  return wave_;
+}
+
+void
+StressWaves::StartWave(GameSession* session)
+{
+  wave_ += 1;
+  const int   size     = kFirstWaveSize * wave_;
+  const float interval = kFirstWaveInterval / wave_;
+
+  Enemies* enemies = session->GetEnemies();
+  enemies->SetSpawnInterval(interval);
+  enemies->SpawnEnemies(size);
+  typer_.SetSpeed(kFirstTypingSpeed + kTypingSpeedRamp * wave_);
+
+  // the next wave starts when this one has spawned
+  time_left_ += size * interval;
+}
@@ -0,0 +1,34 @@
+#ifndef SPACETYPER_STRESSWAVES_H
+#define SPACETYPER_STRESSWAVES_H
+
+#include "spacetyper/sessionhost.h"
+
+class GameSession;
+
+// Endless waves for finding how many entities a machine can keep up with.
+// Every wave is bigger and spawns faster than the one before and there is no
+// cap, a bot types with a speed that follows the waves so there are bullets
+// and explosions as well.
+class StressWaves
+{
+ public:
+  StressWaves();
+
+  // before the session is updated
+  void
+  Update(GameSession* session, float dt);
+
+  // 0 before the first wave
+  int
+  GetWave() const;
+
+ private:
+  void
+  StartWave(GameSession* session);
+
+  int       wave_;
+  float     time_left_;
+  AutoTyper typer_;
+};
+
+#endif  // SPACETYPER_STRESSWAVES_H
@@ -0,0 +1,127 @@
+#include "spacetyper/telemetry.h"
+
+#include <vector>
+
+#include "core/assert.h"
+
+namespace
+{
+  const size_t kBlockSize = 1024;
+
+  // a crash loses at most this much
+  const std::chrono::seconds kFlushInterval{2};
+
+  const std::chrono::milliseconds kIdleSleep{20};
+}
+
+TelemetryWriter::TelemetryWriter()
+    : start_(std::chrono::steady_clock::now())
+    , file_(nullptr)
+    , running_(false)
+    , dropped_(0)
+{
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+  Stop();
+}
+
+bool
+TelemetryWriter::Start(const std::string& path, std::string* error)
+{
+  ASSERT(file_ == nullptr);
+  file_ = std::fopen(path.c_str(), "wb");
+  if(file_ == nullptr)
+  {
+    *error = "Failed to open " + path + " for writing";
+    return false;
+  }
+
+  std::vector<unsigned char> header;
+  EncodeTelemetryHeader(&header);
+  std::fwrite(header.data(), 1, header.size(), file_);
+
+  start_   = std::chrono::steady_clock::now();
+  running_ = true;
+  thread_  = std::thread{&TelemetryWriter::Run, this};
+  return true;
+}
+
+void
+TelemetryWriter::Stop()
+{
+  if(thread_.joinable())
+  {
+    running_ = false;
+    thread_.join();
+  }
+  if(file_ != nullptr)
+  {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+void
+TelemetryWriter::Record(KeystrokeRecord record)
+{
+  record.time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start_)
+                    .count();
+  if(!queue_.Push(record))
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+int
+TelemetryWriter::GetDropped() const
+{
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+void
+TelemetryWriter::Run()
+{
+  std::vector<KeystrokeRecord> block;
+  block.reserve(kBlockSize);
+  auto last_flush = std::chrono::steady_clock::now();
+
+  while(true)
+  {
+    // read the flag before draining so nothing pushed before Stop is lost
+    const bool running = running_;
+
+    KeystrokeRecord record;
+    while(block.size() < kBlockSize && queue_.Pop(&record))
+    {
+      block.push_back(record);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if(block.size() >= kBlockSize ||
+       (!block.empty() && (now - last_flush >= kFlushInterval || !running)))
+    {
+      WriteBlock(&block);
+      last_flush = now;
+      continue;
+    }
+
+    if(!running)
+    {
+      break;
+    }
+    std::this_thread::sleep_for(kIdleSleep);
+  }
+}
+
+void
+TelemetryWriter::WriteBlock(std::vector<KeystrokeRecord>* block)
+{
+  std::vector<unsigned char> data;
+  EncodeTelemetryBlock(*block, &data);
+  std::fwrite(data.data(), 1, data.size(), file_);
+  std::fflush(file_);
+  block->clear();
+}
@@ -0,0 +1,53 @@
+#ifndef SPACETYPER_TELEMETRY_H
+#define SPACETYPER_TELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "spacetyper/spscqueue.h"
+#include "spacetyper/telemetryfile.h"
+
+// Records keystrokes to a file without slowing down input handling. The game
+// thread only copies the record to a lock-free queue, a background thread
+// encodes and writes them in blocks.
+class TelemetryWriter
+{
+ public:
+  TelemetryWriter();
+  ~TelemetryWriter();
+
+  bool
+  Start(const std::string& path, std::string* error);
+
+  // writes everything that is left and closes the file
+  void
+  Stop();
+
+  // game thread only, stamps the time and never waits, if the writer has
+  // fallen behind the record is dropped
+  void
+  Record(KeystrokeRecord record);
+
+  int
+  GetDropped() const;
+
+ private:
+  void
+  Run();
+
+  void
+  WriteBlock(std::vector<KeystrokeRecord>* block);
+
+  // at 150 wpm this is several minutes of typing
+  SpscQueue<KeystrokeRecord, 4096>      queue_;
+  std::chrono::steady_clock::time_point start_;
+  std::FILE*                            file_;
+  std::atomic<bool>                     running_;
+  std::atomic<int>                      dropped_;
+  std::thread                           thread_;
+};
+
+#endif  // SPACETYPER_TELEMETRY_H
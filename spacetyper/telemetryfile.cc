@@ -0,0 +1,306 @@
+#include "spacetyper/telemetryfile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+namespace
+{
+  const uint32_t kVersion = 1;
+
+  void
+  WriteVarint(uint64_t value, std::vector<unsigned char>* out)
+  {
+    while(value >= 0x80)
+    {
+      out->push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    out->push_back(static_cast<unsigned char>(value));
+  }
+
+  uint64_t
+  ZigZag(int64_t value)
+  {
+    return (static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63);
+  }
+
+  int64_t
+  UnZigZag(uint64_t value)
+  {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  class BlockReader
+  {
+   public:
+    BlockReader(const std::vector<unsigned char>& data, size_t position)
+        : data_(data)
+        , position_(position)
+        , ok_(true)
+    {
+    }
+
+    uint64_t
+    ReadVarint()
+    {
+      uint64_t value = 0;
+      for(int shift = 0; shift < 64; shift += 7)
+      {
+        if(position_ >= data_.size())
+        {
+          break;
+        }
+        const unsigned char b = data_[position_++];
+        value |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if((b & 0x80) == 0)
+        {
+          return value;
+        }
+      }
+      ok_ = false;
+      return 0;
+    }
+
+    unsigned char
+    ReadByte()
+    {
+      if(position_ >= data_.size())
+      {
+        ok_ = false;
+        return 0;
+      }
+      return data_[position_++];
+    }
+
+    // a count where each item takes at least one byte
+    size_t
+    ReadCount()
+    {
+      const uint64_t count = ReadVarint();
+      if(count > data_.size() - position_)
+      {
+        ok_ = false;
+        return 0;
+      }
+      return static_cast<size_t>(count);
+    }
+
+    bool
+    IsOk() const
+    {
+      return ok_;
+    }
+
+    size_t
+    GetPosition() const
+    {
+      return position_;
+    }
+
+   private:
+    const std::vector<unsigned char>& data_;
+    size_t                            position_;
+    bool                              ok_;
+  };
+
+  bool
+  DecodeBlock(BlockReader* reader, std::vector<KeystrokeRecord>* records)
+  {
+    const size_t count = reader->ReadCount();
+
+    std::vector<std::string> words(reader->ReadCount());
+    for(std::string& word : words)
+    {
+      const size_t length = reader->ReadCount();
+      for(size_t i = 0; i < length; ++i)
+      {
+        word += static_cast<char>(reader->ReadByte());
+      }
+    }
+    if(!reader->IsOk())
+    {
+      return false;
+    }
+
+    std::vector<KeystrokeRecord> block(count);
+    uint64_t                     time = 0;
+    for(KeystrokeRecord& r : block)
+    {
+      time += reader->ReadVarint();
+      r.time = time;
+    }
+    int64_t reaction = 0;
+    for(KeystrokeRecord& r : block)
+    {
+      reaction += UnZigZag(reader->ReadVarint());
+      r.reaction = static_cast<uint32_t>(reaction);
+    }
+    for(KeystrokeRecord& r : block)
+    {
+      r.expected = static_cast<char>(reader->ReadByte());
+    }
+    for(KeystrokeRecord& r : block)
+    {
+      r.typed = static_cast<char>(reader->ReadByte());
+    }
+    unsigned char bits = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+      if(i % 8 == 0)
+      {
+        bits = reader->ReadByte();
+      }
+      block[i].hit = (bits & (1 << (i % 8))) != 0;
+    }
+    for(KeystrokeRecord& r : block)
+    {
+      const uint64_t index = reader->ReadVarint();
+      if(index >= words.size())
+      {
+        return false;
+      }
+      SetKeystrokeWord(&r, words[index]);
+    }
+
+    if(!reader->IsOk())
+    {
+      return false;
+    }
+    records->insert(records->end(), block.begin(), block.end());
+    return true;
+  }
+}
+
+void
+SetKeystrokeWord(KeystrokeRecord* record, const std::string& word)
+{
+  const size_t length = std::min<size_t>(word.size(), kTelemetryWordSize - 1);
+  std::memcpy(record->word, word.data(), length);
+  record->word[length] = 0;
+}
+
+void
+EncodeTelemetryHeader(std::vector<unsigned char>* out)
+{
+  const char magic[] = "STTL";
+  out->insert(out->end(), magic, magic + 4);
+  for(int i = 0; i < 4; ++i)
+  {
+    out->push_back(static_cast<unsigned char>(kVersion >> (i * 8)));
+  }
+}
+
+void
+EncodeTelemetryBlock(
+    const std::vector<KeystrokeRecord>& records,
+    std::vector<unsigned char>*         out)
+{
+  WriteVarint(records.size(), out);
+
+  // the same few words are typed over and over so store them once
+  std::map<std::string, uint64_t> word_indices;
+  std::vector<const char*>        words;
+  std::vector<uint64_t>           indices;
+  indices.reserve(records.size());
+  for(const KeystrokeRecord& r : records)
+  {
+    const auto inserted =
+        word_indices.insert(std::make_pair(r.word, words.size()));
+    if(inserted.second)
+    {
+      words.push_back(r.word);
+    }
+    indices.push_back(inserted.first->second);
+  }
+  WriteVarint(words.size(), out);
+  for(const char* word : words)
+  {
+    const size_t length = std::strlen(word);
+    WriteVarint(length, out);
+    out->insert(out->end(), word, word + length);
+  }
+
+  uint64_t time = 0;
+  for(const KeystrokeRecord& r : records)
+  {
+    WriteVarint(r.time - time, out);
+    time = r.time;
+  }
+  int64_t reaction = 0;
+  for(const KeystrokeRecord& r : records)
+  {
+    WriteVarint(ZigZag(static_cast<int64_t>(r.reaction) - reaction), out);
+    reaction = r.reaction;
+  }
+  for(const KeystrokeRecord& r : records)
+  {
+    out->push_back(static_cast<unsigned char>(r.expected));
+  }
+  for(const KeystrokeRecord& r : records)
+  {
+    out->push_back(static_cast<unsigned char>(r.typed));
+  }
+  for(size_t i = 0; i < records.size(); i += 8)
+  {
+    unsigned char bits = 0;
+    for(size_t b = 0; b < 8 && i + b < records.size(); ++b)
+    {
+      if(records[i + b].hit)
+      {
+        bits |= 1 << b;
+      }
+    }
+    out->push_back(bits);
+  }
+  for(uint64_t index : indices)
+  {
+    WriteVarint(index, out);
+  }
+}
+
+bool
+ReadTelemetryFile(
+    const std::string&            path,
+    std::vector<KeystrokeRecord>* records,
+    std::string*                  error)
+{
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if(f == nullptr)
+  {
+    *error = "Failed to open " + path;
+    return false;
+  }
+  std::vector<unsigned char> data;
+  unsigned char              buffer[4096];
+  size_t                     read = 0;
+  while((read = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+  {
+    data.insert(data.end(), buffer, buffer + read);
+  }
+  std::fclose(f);
+
+  std::vector<unsigned char> header;
+  EncodeTelemetryHeader(&header);
+  if(data.size() < header.size() ||
+     !std::equal(header.begin(), header.end(), data.begin()))
+  {
+    *error = path + " is not a telemetry file of this version";
+    return false;
+  }
+
+  size_t position = header.size();
+  while(position < data.size())
+  {
+    BlockReader reader{data, position};
+    if(!DecodeBlock(&reader, records))
+    {
+      // most likely the game didn't exit cleanly
+      break;
+    }
+    position = reader.GetPosition();
+  }
+  return true;
+}
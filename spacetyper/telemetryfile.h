@@ -0,0 +1,57 @@
+#ifndef SPACETYPER_TELEMETRYFILE_H
+#define SPACETYPER_TELEMETRYFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// longer words are truncated
+const int kTelemetryWordSize = 24;
+
+// one typed character
+struct KeystrokeRecord
+{
+  // microseconds since the recording started
+  uint64_t time;
+  // milliseconds since the target word spawned, 0 without a target
+  uint32_t reaction;
+  // the character the target expected, 0 without a target
+  char expected;
+  // non ascii input is stored as ?
+  char typed;
+  bool hit;
+  // zero terminated, empty without a target
+  char word[kTelemetryWordSize];
+};
+
+void
+SetKeystrokeWord(KeystrokeRecord* record, const std::string& word);
+
+// The file is the header followed by independent blocks so a file cut off
+// by a crash loses at most the last block:
+//   "STTL", version (little endian uint32)
+//   per block, all integers as LEB128 varints:
+//     record count
+//     word table: count, then length and bytes per word
+//     time column: first value, then deltas
+//     reaction column: zigzag deltas
+//     expected and typed columns: one byte each
+//     hit column: one bit per record
+//     word column: index into the word table
+void
+EncodeTelemetryHeader(std::vector<unsigned char>* out);
+
+void
+EncodeTelemetryBlock(
+    const std::vector<KeystrokeRecord>& records,
+    std::vector<unsigned char>*         out);
+
+// returns false if the file can't be read or the header is wrong, a broken
+// final block is ignored
+bool
+ReadTelemetryFile(
+    const std::string&            path,
+    std::vector<KeystrokeRecord>* records,
+    std::string*                  error);
+
+#endif  // SPACETYPER_TELEMETRYFILE_H
@@ -0,0 +1,119 @@
+#include "spacetyper/textinput.h"
+
+std::size_t
+DecodeUtf8(const std::string& str, std::size_t position, char32_t* codepoint)
+{
+  if(position >= str.size())
+  {
+    return 0;
+  }
+
+  const unsigned char first  = static_cast<unsigned char>(str[position]);
+  std::size_t         length = 1;
+  char32_t            value  = first;
+  if(first >= 0xF8)
+  {
+    // not a lead byte in any utf-8 sequence
+  }
+  else if(first >= 0xF0)
+  {
+    length = 4;
+    value  = first & 0x07;
+  }
+  else if(first >= 0xE0)
+  {
+    length = 3;
+    value  = first & 0x0F;
+  }
+  else if(first >= 0xC0)
+  {
+    length = 2;
+    value  = first & 0x1F;
+  }
+
+  if(length > 1)
+  {
+    if(position + length > str.size())
+    {
+      *codepoint = first;
+      return 1;
+    }
+    for(std::size_t i = 1; i < length; ++i)
+    {
+      const unsigned char c = static_cast<unsigned char>(str[position + i]);
+      if((c & 0xC0) != 0x80)
+      {
+        *codepoint = first;
+        return 1;
+      }
+      value = (value << 6) | (c & 0x3F);
+    }
+  }
+
+  *codepoint = value;
+  return length;
+}
+
+std::size_t
+CountUtf8(const std::string& str)
+{
+  std::size_t count     = 0;
+  std::size_t position  = 0;
+  char32_t    codepoint = 0;
+  while(const std::size_t length = DecodeUtf8(str, position, &codepoint))
+  {
+    position += length;
+    count += 1;
+  }
+  return count;
+}
+
+TextInputQueue::TextInputQueue()
+    : first_(0)
+    , count_(0)
+    , dropped_(0)
+{
+}
+
+void
+TextInputQueue::Push(const std::string& utf8)
+{
+  std::size_t position  = 0;
+  char32_t    codepoint = 0;
+  while(const std::size_t length = DecodeUtf8(utf8, position, &codepoint))
+  {
+    position += length;
+    if(count_ == kCapacity)
+    {
+      dropped_ += 1;
+      continue;
+    }
+    buffer_[(first_ + count_) % kCapacity] = codepoint;
+    count_ += 1;
+  }
+}
+
+bool
+TextInputQueue::Pop(char32_t* codepoint)
+{
+  if(count_ == 0)
+  {
+    return false;
+  }
+  *codepoint = buffer_[first_];
+  first_     = (first_ + 1) % kCapacity;
+  count_ -= 1;
+  return true;
+}
+
+bool
+TextInputQueue::IsEmpty() const
+{
+  return count_ == 0;
+}
+
+int
+TextInputQueue::GetDropped() const
+{
+  return dropped_;
+}
@@ -0,0 +1,47 @@
+#ifndef SPACETYPER_TEXTINPUT_H
+#define SPACETYPER_TEXTINPUT_H
+
+#include <cstddef>
+#include <string>
+
+// Decodes the utf-8 code point at position, returns the number of bytes it
+// took or 0 if position is at the end. Invalid bytes decode as themselves
+// one byte at a time so broken input can't stall the caller.
+std::size_t
+DecodeUtf8(const std::string& str, std::size_t position, char32_t* codepoint);
+
+// the number of code points DecodeUtf8 splits the string into
+std::size_t
+CountUtf8(const std::string& str);
+
+// Text input events can contain any number of characters (ime commits,
+// pastes, bursts of key repeats). They are queued as code points here and
+// consumed once per frame.
+class TextInputQueue
+{
+ public:
+  TextInputQueue();
+
+  // characters that don't fit are dropped
+  void
+  Push(const std::string& utf8);
+
+  bool
+  Pop(char32_t* codepoint);
+
+  bool
+  IsEmpty() const;
+
+  int
+  GetDropped() const;
+
+ private:
+  static const std::size_t kCapacity = 256;
+
+  char32_t    buffer_[kCapacity];
+  std::size_t first_;
+  std::size_t count_;
+  int         dropped_;
+};
+
+#endif  // SPACETYPER_TEXTINPUT_H
@@ -0,0 +1,296 @@
+#include "spacetyper/timerwheel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/assert.h"
+
+namespace
+{
+  const float kTicksPerSecond = 1000.0f;
+
+  int
+  LowestBit(uint64_t bits)
+  {
+    ASSERT(bits != 0);
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+  }
+}
+
+TimerWheel::TimerWheel()
+    : free_(-1)
+    , now_(0)
+    , remainder_(0.0f)
+    , pending_(0)
+{
+  std::fill(heads_, heads_ + kLevels * kSlots, -1);
+  std::fill(tails_, tails_ + kLevels * kSlots, -1);
+  std::fill(occupied_, occupied_ + kLevels, 0);
+}
+
+TimerId
+TimerWheel::Schedule(float delay, Callback callback)
+{
+  ASSERT(callback);
+  int index = free_;
+  if(index != -1)
+  {
+    free_ = nodes_[index].next;
+  }
+  else
+  {
+    index = nodes_.size();
+    nodes_.push_back(Node{0, 0, -1, -1, -1, nullptr});
+  }
+
+  const float ticks = remainder_ + std::max(0.0f, delay) * kTicksPerSecond;
+  Node&       node  = nodes_[index];
+  node.expiry       = now_ + std::max<uint64_t>(1, std::ceil(ticks));
+  node.callback     = std::move(callback);
+  Insert(index);
+  pending_ += 1;
+
+  return (static_cast<TimerId>(node.generation) << 32) | (index + 1);
+}
+
+bool
+TimerWheel::Cancel(TimerId id)
+{
+  if(Find(id) == nullptr)
+  {
+    return false;
+  }
+  const int index = static_cast<int>(id & 0xFFFFFFFF) - 1;
+  Unlink(index);
+  Release(index);
+  return true;
+}
+
+bool
+TimerWheel::IsPending(TimerId id) const
+{
+  return Find(id) != nullptr;
+}
+
+float
+TimerWheel::GetRemaining(TimerId id) const
+{
+  const Node* node = Find(id);
+  if(node == nullptr)
+  {
+    return 0.0f;
+  }
+  const float ticks = static_cast<float>(node->expiry - now_) - remainder_;
+  return std::max(0.0f, ticks / kTicksPerSecond);
+}
+
+void
+TimerWheel::Advance(float dt)
+{
+  const float    total    = remainder_ + dt * kTicksPerSecond;
+  const uint64_t ticks    = static_cast<uint64_t>(std::floor(total));
+  const float    fraction = total - ticks;
+  const uint64_t end      = now_ + ticks;
+
+  // callbacks see the time of their own tick, the ticks in between have
+  // nothing to fire or cascade so they are skipped
+  remainder_ = 0.0f;
+  for(uint64_t next = GetNextEvent(); next <= end; next = GetNextEvent())
+  {
+    now_ = next - 1;
+    Tick();
+  }
+  now_       = end;
+  remainder_ = fraction;
+}
+
+double
+TimerWheel::GetTime() const
+{
+  return (static_cast<double>(now_) + remainder_) / kTicksPerSecond;
+}
+
+int
+TimerWheel::GetPendingCount() const
+{
+  return pending_;
+}
+
+const TimerWheel::Node*
+TimerWheel::Find(TimerId id) const
+{
+  const uint64_t index      = (id & 0xFFFFFFFF);
+  const uint32_t generation = static_cast<uint32_t>(id >> 32);
+  if(index == 0 || index > nodes_.size())
+  {
+    return nullptr;
+  }
+  const Node& node = nodes_[index - 1];
+  if(node.slot == -1 || node.generation != generation)
+  {
+    return nullptr;
+  }
+  return &node;
+}
+
+void
+TimerWheel::Insert(int index)
+{
+  Node& node = nodes_[index];
+
+  // the lowest level where the timer is in the same block as now, so it is
+  // cascaded down before it's due
+  int level = 0;
+  int slot  = 0;
+  for(; level < kLevels; ++level)
+  {
+    const int block_bits = kSlotBits * (level + 1);
+    if((node.expiry >> block_bits) == (now_ >> block_bits))
+    {
+      slot = (node.expiry >> (kSlotBits * level)) & (kSlots - 1);
+      break;
+    }
+  }
+  if(level == kLevels)
+  {
+    // hours away, the first slot of the top level is only cascaded when the
+    // whole wheel rolls over so park it there and look again then
+    level = kLevels - 1;
+    slot  = 0;
+  }
+
+  const int list = level * kSlots + slot;
+  occupied_[level] |= uint64_t(1) << slot;
+  node.slot = list;
+  node.next      = -1;
+  node.prev      = tails_[list];
+  if(tails_[list] != -1)
+  {
+    nodes_[tails_[list]].next = index;
+  }
+  else
+  {
+    heads_[list] = index;
+  }
+  tails_[list] = index;
+}
+
+void
+TimerWheel::Unlink(int index)
+{
+  Node& node = nodes_[index];
+  if(node.prev != -1)
+  {
+    nodes_[node.prev].next = node.next;
+  }
+  else
+  {
+    heads_[node.slot] = node.next;
+  }
+  if(node.next != -1)
+  {
+    nodes_[node.next].prev = node.prev;
+  }
+  else
+  {
+    tails_[node.slot] = node.prev;
+  }
+  if(heads_[node.slot] == -1)
+  {
+    occupied_[node.slot / kSlots] &= ~(uint64_t(1) << (node.slot % kSlots));
+  }
+}
+
+uint64_t
+TimerWheel::GetNextEvent() const
+{
+  uint64_t next = UINT64_MAX;
+  for(int level = 0; level < kLevels; ++level)
+  {
+    // a slot after the current one fires or cascades when the level reaches
+    // it, anything else is in the current slot of the top level and waits
+    // for the whole wheel to roll over
+    const int      shift   = kSlotBits * level;
+    const int      current = (now_ >> shift) & (kSlots - 1);
+    const uint64_t later =
+        occupied_[level] & ~((uint64_t(2) << current) - 1);
+    if(later != 0)
+    {
+      const int      block_shift = shift + kSlotBits;
+      const uint64_t block       = (now_ >> block_shift) << block_shift;
+      next = std::min(next, block + (uint64_t(LowestBit(later)) << shift));
+    }
+    else if(occupied_[level] != 0)
+    {
+      ASSERT(level == kLevels - 1);
+      const int bits = kSlotBits * kLevels;
+      next           = std::min(next, ((now_ >> bits) + 1) << bits);
+    }
+  }
+  return next;
+}
+
+void
+TimerWheel::Release(int index)
+{
+  Node& node    = nodes_[index];
+  node.slot     = -1;
+  node.callback = nullptr;
+  node.generation += 1;
+  node.next = free_;
+  free_     = index;
+  pending_ -= 1;
+}
+
+void
+TimerWheel::Cascade(int level)
+{
+  const int slot = (now_ >> (kSlotBits * level)) & (kSlots - 1);
+  const int list  = level * kSlots + slot;
+  int       index = heads_[list];
+  heads_[list]    = -1;
+  tails_[list]    = -1;
+  occupied_[level] &= ~(uint64_t(1) << slot);
+  while(index != -1)
+  {
+    const int next = nodes_[index].next;
+    Insert(index);
+    index = next;
+  }
+}
+
+void
+TimerWheel::Tick()
+{
+  now_ += 1;
+
+  // every level that rolled over, from the top so the timers trickle down
+  int top = 0;
+  while(top + 1 < kLevels &&
+        (now_ & ((uint64_t(1) << (kSlotBits * (top + 1))) - 1)) == 0)
+  {
+    top += 1;
+  }
+  for(int level = top; level > 0; --level)
+  {
+    Cascade(level);
+  }
+
+  const int list = now_ & (kSlots - 1);
+  while(heads_[list] != -1)
+  {
+    const int index = heads_[list];
+    ASSERT(nodes_[index].expiry == now_);
+    Unlink(index);
+    // the callback may schedule timers and grow the node list
+    Callback callback = std::move(nodes_[index].callback);
+    Release(index);
+    callback();
+  }
+}
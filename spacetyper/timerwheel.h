@@ -0,0 +1,100 @@
+#ifndef SPACETYPER_TIMERWHEEL_H
+#define SPACETYPER_TIMERWHEEL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 0 is never a valid timer
+typedef uint64_t TimerId;
+
+// Hierarchical timer wheel on simulation time. Timers are kept in 4 levels
+// of 64 slots with a resolution of 1ms, a timer only moves when its level
+// rolls over, so a timer costs nothing between being scheduled and firing.
+// A bitmap of the occupied slots per level lets advancing jump straight to
+// the next slot that fires or cascades, so it costs the expired and
+// cascaded timers and not the elapsed ms.
+class TimerWheel
+{
+ public:
+  typedef std::function<void()> Callback;
+
+  TimerWheel();
+
+  // seconds from now, rounded up to the next ms
+  TimerId
+  Schedule(float delay, Callback callback);
+
+  // returns false if the timer already fired or was cancelled
+  bool
+  Cancel(TimerId id);
+
+  bool
+  IsPending(TimerId id) const;
+
+  // seconds until the timer fires, 0 if it isn't pending
+  float
+  GetRemaining(TimerId id) const;
+
+  // fires the timers in order, callbacks may schedule and cancel timers
+  void
+  Advance(float dt);
+
+  // seconds since the wheel was created
+  double
+  GetTime() const;
+
+  int
+  GetPendingCount() const;
+
+ private:
+  static const int kLevels   = 4;
+  static const int kSlotBits = 6;
+  static const int kSlots    = 1 << kSlotBits;
+
+  struct Node
+  {
+    uint64_t expiry;
+    uint32_t generation;
+    int      next;
+    int      prev;
+    // -1 when free
+    int      slot;
+    Callback callback;
+  };
+
+  const Node*
+  Find(TimerId id) const;
+
+  void
+  Insert(int index);
+
+  void
+  Unlink(int index);
+
+  // the next tick where a slot fires or cascades, max if nothing is pending
+  uint64_t
+  GetNextEvent() const;
+
+  void
+  Release(int index);
+
+  void
+  Cascade(int level);
+
+  void
+  Tick();
+
+  std::vector<Node> nodes_;
+  int               free_;
+  // first node in every slot, levels after each other
+  int      heads_[kLevels * kSlots];
+  int      tails_[kLevels * kSlots];
+  // a bit per non-empty slot, kSlots is the number of bits
+  uint64_t occupied_[kLevels];
+  uint64_t now_;
+  float    remainder_;
+  int      pending_;
+};
+
+#endif  // SPACETYPER_TIMERWHEEL_H
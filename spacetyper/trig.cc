@@ -0,0 +1,122 @@
+#include "spacetyper/trig.h"
+
+// Build time checks of the error bounds in trig.h against double precision
+// references, a change to a polynomial that breaks a bound fails the build.
+
+namespace
+{
+  constexpr double kRefPi = 3.14159265358979323846;
+
+  constexpr double
+  RefAbs(double x)
+  {
+    return x < 0.0 ? -x : x;
+  }
+
+  constexpr double
+  RefSqrt(double x)
+  {
+    if(x <= 0.0)
+    {
+      return 0.0;
+    }
+    double r = x > 1.0 ? x : 1.0;
+    for(int i = 0; i < 64; ++i)
+    {
+      r = 0.5 * (r + x / r);
+    }
+    return r;
+  }
+
+  // taylor series, x in [-pi, pi]
+  constexpr double
+  RefSin(double x)
+  {
+    double term = x;
+    double sum  = x;
+    for(int n = 1; n < 30; ++n)
+    {
+      term *= -x * x / ((2 * n) * (2 * n + 1));
+      sum += term;
+    }
+    return sum;
+  }
+
+  // halves the angle twice so the taylor series converges quickly
+  constexpr double
+  RefAtan(double x)
+  {
+    double a = x;
+    for(int i = 0; i < 2; ++i)
+    {
+      a = a / (1.0 + RefSqrt(1.0 + a * a));
+    }
+    double term = a;
+    double sum  = a;
+    for(int n = 1; n < 40; ++n)
+    {
+      term *= -a * a;
+      sum += term / (2 * n + 1);
+    }
+    return sum * 4.0;
+  }
+
+  constexpr double
+  RefAtan2(double y, double x)
+  {
+    const double ax = RefAbs(x);
+    const double ay = RefAbs(y);
+    double r = ay > ax ? kRefPi / 2.0 - RefAtan(ax / ay) : RefAtan(ay / ax);
+    if(x < 0.0)
+    {
+      r = kRefPi - r;
+    }
+    return y < 0.0 ? -r : r;
+  }
+
+  constexpr double
+  MaxSinError()
+  {
+    double error = 0.0;
+    for(int i = 0; i <= 1000; ++i)
+    {
+      const double x = -kRefPi + 2.0 * kRefPi * i / 1000.0;
+      const double s = RefAbs(FastSin(static_cast<float>(x)) - RefSin(x));
+      const double c = RefAbs(
+          FastCos(static_cast<float>(x)) -
+          RefSin(x >= kRefPi / 2.0 ? x - 1.5 * kRefPi : x + kRefPi / 2.0));
+      error = s > error ? s : error;
+      error = c > error ? c : error;
+    }
+    return error;
+  }
+
+  constexpr double
+  MaxAtan2Error()
+  {
+    double error = 0.0;
+    for(int i = 0; i < 1000; ++i)
+    {
+      // points on a circle, float rounded before the reference sees them
+      const double t = 2.0 * kRefPi * i / 1000.0;
+      const float x = static_cast<float>(RefSin(
+          t + kRefPi / 2.0 > kRefPi ? t - 1.5 * kRefPi : t + kRefPi / 2.0));
+      const float y =
+          static_cast<float>(RefSin(t > kRefPi ? t - 2.0 * kRefPi : t));
+      const double e = RefAbs(FastAtan2(y, x) - RefAtan2(y, x));
+      error          = e > error ? e : error;
+    }
+    return error;
+  }
+
+  static_assert(RefAbs(kPi - kRefPi) < 1e-6, "pi is pi");
+  static_assert(MaxSinError() < 5e-6, "sin and cos are within their bound");
+  static_assert(MaxAtan2Error() < 3e-6, "atan2 is within its bound");
+  static_assert(FastAtan2(0.0f, 0.0f) == 0.0f, "atan2 of zero is defined");
+  static_assert(
+      RefAbs(FastAtan2(1.0f, 0.0f) - kRefPi / 2.0) < 3e-6,
+      "atan2 handles the y axis");
+  static_assert(
+      RefAbs(FastAtan2(0.0f, -1.0f) - kRefPi) < 3e-6,
+      "atan2 handles the negative x axis");
+}
@@ -0,0 +1,115 @@
+#ifndef SPACETYPER_TRIG_H
+#define SPACETYPER_TRIG_H
+
+#include <cmath>
+
+#include "core/angle.h"
+#include "core/vec2.h"
+
+// Polynomial trig that is cheaper than the libm calls and usable in
+// constant expressions. The error bounds are checked against a double
+// precision reference at build time in trig.cc:
+//   FastSin, FastCos  4e-6 + float rounding
+//   FastAtan2         2e-6 + float rounding, FastAcos adds a sqrt to that
+
+constexpr float kPi     = 3.14159265358979323846f;
+constexpr float kHalfPi = kPi / 2.0f;
+constexpr float kTau    = kPi * 2.0f;
+
+constexpr float
+FastAbs(float x)
+{
+  return x < 0.0f ? -x : x;
+}
+
+// to [-pi, pi], loses precision far away from 0 like all float angles
+constexpr float
+WrapAngle(float x)
+{
+  const float turns = x / kTau;
+  const float whole = static_cast<float>(
+      static_cast<long long>(turns + (turns >= 0.0f ? 0.5f : -0.5f)));
+  return x - whole * kTau;
+}
+
+constexpr float
+FastSin(float x)
+{
+  // sin(pi - x) = sin(x) folds [-pi, pi] to [-pi/2, pi/2] where the taylor
+  // polynomial to x^9 is good enough
+  float a = WrapAngle(x);
+  if(a > kHalfPi)
+  {
+    a = kPi - a;
+  }
+  else if(a < -kHalfPi)
+  {
+    a = -kPi - a;
+  }
+  const float s = a * a;
+  return a *
+         (1.0f +
+          s * (-1.0f / 6.0f +
+               s * (1.0f / 120.0f +
+                    s * (-1.0f / 5040.0f + s * (1.0f / 362880.0f)))));
+}
+
+constexpr float
+FastCos(float x)
+{
+  return FastSin(x + kHalfPi);
+}
+
+// minimax polynomial for atan on [0, 1]
+constexpr float
+FastAtanUnit(float x)
+{
+  const float s = x * x;
+  return x *
+         (0.99997726f +
+          s * (-0.33262347f +
+               s * (0.19354346f +
+                    s * (-0.11643287f +
+                         s * (0.05265332f + s * -0.01172120f)))));
+}
+
+constexpr float
+FastAtan2(float y, float x)
+{
+  const float ax = FastAbs(x);
+  const float ay = FastAbs(y);
+  if(ax == 0.0f && ay == 0.0f)
+  {
+    return 0.0f;
+  }
+  float r = ay > ax ? kHalfPi - FastAtanUnit(ax / ay) : FastAtanUnit(ay / ax);
+  if(x < 0.0f)
+  {
+    r = kPi - r;
+  }
+  return y < 0.0f ? -r : r;
+}
+
+constexpr float
+FastAtan(float x)
+{
+  return FastAtan2(x, 1.0f);
+}
+
+// not constexpr since it needs a sqrt
+inline float
+FastAcos(float x)
+{
+  const float c = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+  return FastAtan2(std::sqrt(1.0f - c * c), c);
+}
+
+// the sprite rotation that turns the up vector (0, 1) to point along the
+// direction, the direction doesn't need to be normalized
+inline Angle
+GetDirectionAngle(const vec2f& direction)
+{
+  return Angle::FromRadians(FastAtan2(-direction.x, direction.y));
+}
+
+#endif  // SPACETYPER_TRIG_H
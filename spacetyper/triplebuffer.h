@@ -0,0 +1,72 @@
+#ifndef SPACETYPER_TRIPLEBUFFER_H
+#define SPACETYPER_TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free hand over of whole frames from one producer thread to one
+// consumer thread. The producer always has a buffer to write to, the consumer
+// always has the latest published buffer to read from and the third buffer
+// is swapped between them with a single atomic exchange.
+template <typename T>
+class TripleBuffer
+{
+ public:
+  TripleBuffer()
+      : middle_(1)
+      , write_(0)
+      , read_(2)
+  {
+  }
+
+  // producer side
+  T&
+  GetWriteBuffer()
+  {
+    return buffers_[write_];
+  }
+
+  void
+  Publish()
+  {
+    const int old =
+        middle_.exchange(write_ | kNewBit, std::memory_order_acq_rel);
+    write_ = old & kIndexMask;
+  }
+
+  // true if the last published buffer hasn't been fetched yet
+  bool
+  HasPending() const
+  {
+    return (middle_.load(std::memory_order_acquire) & kNewBit) != 0;
+  }
+
+  // consumer side, returns false if nothing new was published
+  bool
+  Fetch()
+  {
+    if(!HasPending())
+    {
+      return false;
+    }
+    const int old = middle_.exchange(read_, std::memory_order_acq_rel);
+    read_         = old & kIndexMask;
+    return true;
+  }
+
+  T&
+  GetReadBuffer()
+  {
+    return buffers_[read_];
+  }
+
+ private:
+  static const int kIndexMask = 3;
+  static const int kNewBit    = 4;
+
+  T                buffers_[3];
+  std::atomic<int> middle_;
+  int              write_;
+  int              read_;
+};
+
+#endif  // SPACETYPER_TRIPLEBUFFER_H
@@ -1,23 +1,64 @@
 #include "spacetyper/wordlist.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
-Wordlist::Wordlist(const std::string& path) : generator_(std::random_device()()) {
+#include "core/assert.h"
+
+Wordlist::Wordlist(const std::string& path) {
   std::ifstream f(path.c_str());
   if( !f.good() ) {
     std::cerr << "Failed to load wordlist " << path << "\n";
   }
-  std::string word;
-  while( f >> word ){
+  std::vector<float> weights;
+  bool weighted = false;
+  std::string line;
+  while( std::getline(f, line) ){
+    std::istringstream ss(line);
+    std::string word;
+    if( !(ss >> word) ) {
+      continue;
+    }
+    unsigned int count = 1;
+    if( ss >> count ) {
+      weighted = true;
+    }
     words_.push_back(word);
+    // the most common words in code are a lot more common than the rest,
+    // flatten it so the list doesn't become a few keywords on repeat
+    weights.push_back(std::sqrt(static_cast<float>(count)));
+  }
+
+  if( weighted ) {
+    float total = 0.0f;
+    cumulative_weights_.reserve(weights.size());
+    for(float w : weights) {
+      total += w;
+      cumulative_weights_.push_back(total);
+    }
   }
 }
 
-const std::string Wordlist::RandomWord() const {
-  const size_t index = std::uniform_int_distribution<size_t>(0, words_.size())(generator_);
-  std::cout << index << " ";
-  std::string w = words_[index];
-  std::cout << w << "\n";
-  return w;
+bool Wordlist::IsEmpty() const {
+  return words_.empty();
+}
+
+const std::string Wordlist::RandomWord(std::mt19937* generator) const {
+  ASSERT(!words_.empty());
+  if( cumulative_weights_.empty() ) {
+    const size_t index = std::uniform_int_distribution<size_t>(
+        0, words_.size() - 1)(*generator);
+    return words_[index];
+  }
+
+  const float r = std::uniform_real_distribution<float>(
+      0.0f, cumulative_weights_.back())(*generator);
+  const auto found = std::upper_bound(
+      cumulative_weights_.begin(), cumulative_weights_.end(), r);
+  const size_t index = std::min<size_t>(
+      found - cumulative_weights_.begin(), words_.size() - 1);
+  return words_[index];
 }
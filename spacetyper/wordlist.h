@@ -5,15 +5,21 @@
 #include <vector>
 #include <random>
 
+// One word per line, optionally followed by how common the word is, like
+// the lists generated by wordscan. Common words are picked more often.
 class Wordlist {
  public:
   Wordlist(const std::string& path);
 
-  const std::string RandomWord() const;
+  bool IsEmpty() const;
+
+  // the list must not be empty
+  const std::string RandomWord(std::mt19937* generator) const;
 
  private:
-  mutable std::mt19937 generator_;
   std::vector<std::string> words_;
+  // running total of the weights, empty if the list has no counts
+  std::vector<float> cumulative_weights_;
 };
 
 #endif  // SPACETYPER_WORDLIST_H
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "spacetyper/telemetryfile.h"
+
+// Prints a summary of a keystroke telemetry file recorded with
+// spacetyper --telemetry, or all the keystrokes as csv:
+//   teledump telemetry.sttl
+//   teledump --csv telemetry.sttl > keystrokes.csv
+
+std::string
+CsvChar(char c)
+{
+  if(c == 0)
+  {
+    return "";
+  }
+  if(c == '"' || c == ',')
+  {
+    return std::string("\"") + (c == '"' ? "\"\"" : ",") + "\"";
+  }
+  return std::string(1, c);
+}
+
+void
+PrintCsv(const std::vector<KeystrokeRecord>& records)
+{
+  std::cout << "time_us,reaction_ms,expected,typed,hit,word\n";
+  for(const KeystrokeRecord& r : records)
+  {
+    std::cout << r.time << "," << r.reaction << "," << CsvChar(r.expected)
+              << "," << CsvChar(r.typed) << "," << (r.hit ? 1 : 0) << ","
+              << r.word << "\n";
+  }
+}
+
+void
+PrintSummary(const std::vector<KeystrokeRecord>& records)
+{
+  int                 hits = 0;
+  std::map<char, int> misses;
+  // the reaction of the first keystroke on a word is how long it took to
+  // find and start typing it
+  double reaction_sum   = 0;
+  int    reaction_count = 0;
+  for(const KeystrokeRecord& r : records)
+  {
+    if(r.hit)
+    {
+      ++hits;
+    }
+    else if(r.expected != 0)
+    {
+      misses[r.expected] += 1;
+    }
+    if(r.hit && r.expected != 0 && r.word[0] == r.expected &&
+       r.expected == r.typed)
+    {
+      reaction_sum += r.reaction;
+      ++reaction_count;
+    }
+  }
+
+  const double seconds =
+      records.size() < 2
+          ? 0.0
+          : (records.back().time - records.front().time) / 1000000.0;
+
+  std::cout << records.size() << " keystrokes, " << hits << " hits";
+  if(!records.empty())
+  {
+    std::cout << " (" << (100.0 * hits / records.size()) << "% accuracy)";
+  }
+  std::cout << "\n";
+  if(seconds > 0.0)
+  {
+    // a word is 5 characters
+    std::cout << (hits / 5.0) / (seconds / 60.0) << " wpm over " << seconds
+              << "s\n";
+  }
+  if(reaction_count > 0)
+  {
+    std::cout << reaction_sum / reaction_count
+              << "ms average from spawn to first character\n";
+  }
+  for(const auto& m : misses)
+  {
+    std::cout << "missed '" << m.first << "' " << m.second << " times\n";
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  bool        csv = false;
+  std::string path;
+  for(int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if(arg == "--csv")
+    {
+      csv = true;
+    }
+    else
+    {
+      path = arg;
+    }
+  }
+
+  if(path.empty())
+  {
+    std::cerr << "Usage: " << argv[0] << " [--csv] telemetry.sttl\n";
+    return -1;
+  }
+
+  std::vector<KeystrokeRecord> records;
+  std::string                  error;
+  if(!ReadTelemetryFile(path, &records, &error))
+  {
+    std::cerr << error << "\n";
+    return -2;
+  }
+
+  if(csv)
+  {
+    PrintCsv(records);
+  }
+  else
+  {
+    PrintSummary(records);
+  }
+
+  return 0;
+}
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wordscan/tokenizer.h"
+
+// Builds a dictionary from the identifiers, keywords and operators in a
+// source tree so you can practice on your own code:
+//   wordscan ~/dev/project -o dist/wordlist_project.txt
+//   spacetyper --dictionary wordlist_project.txt
+// The output has the most common words first with their counts, the game
+// picks words weighted by the count.
+
+const char* const kExtensions[] = {
+    ".c",  ".cc",  ".cpp", ".cxx", ".h",  ".hh", ".hpp", ".hxx", ".inl",
+    ".m",  ".mm",  ".cs",  ".java", ".js", ".ts", ".go", ".rs",  ".swift",
+    ".py", ".lua", ".glsl", ".vert", ".frag"};
+
+bool
+HasSourceExtension(const std::string& name)
+{
+  const std::size_t dot = name.rfind('.');
+  if(dot == std::string::npos)
+  {
+    return false;
+  }
+  const std::string extension = name.substr(dot);
+  for(const char* e : kExtensions)
+  {
+    if(extension == e)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+FindSourceFiles(const std::string& dir, std::vector<std::string>* files)
+{
+  DIR* d = opendir(dir.c_str());
+  if(d == nullptr)
+  {
+    std::cerr << "Failed to open " << dir << "\n";
+    return;
+  }
+  while(dirent* entry = readdir(d))
+  {
+    const std::string name = entry->d_name;
+    // skips . and .. as well as .git and friends
+    if(name.empty() || name[0] == '.')
+    {
+      continue;
+    }
+    const std::string path = dir + "/" + name;
+    struct stat       st;
+    if(stat(path.c_str(), &st) != 0)
+    {
+      continue;
+    }
+    if(S_ISDIR(st.st_mode))
+    {
+      FindSourceFiles(path, files);
+    }
+    else if(S_ISREG(st.st_mode) && HasSourceExtension(name))
+    {
+      files->push_back(path);
+    }
+  }
+  closedir(d);
+}
+
+// returns the number of bytes tokenized
+std::size_t
+TokenizeFile(
+    const std::string&       path,
+    const TokenizerSettings& settings,
+    WordCounts*              counts)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+  {
+    return 0;
+  }
+  struct stat st;
+  std::size_t size = 0;
+  if(fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    size = static_cast<std::size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data != MAP_FAILED)
+    {
+      madvise(data, size, MADV_SEQUENTIAL);
+      Tokenize(static_cast<const char*>(data), size, settings, counts);
+      munmap(data, size);
+    }
+    else
+    {
+      size = 0;
+    }
+  }
+  close(fd);
+  return size;
+}
+
+struct RankedWord
+{
+  std::string  word;
+  unsigned int count;
+};
+
+int
+main(int argc, char** argv)
+{
+  std::string       root;
+  std::string       output;
+  std::size_t       max_words    = 2000;
+  unsigned int      thread_count = std::thread::hardware_concurrency();
+  TokenizerSettings settings;
+  settings.min_length = 2;
+  settings.max_length = 20;
+  settings.symbols    = true;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if(arg == "-o" && i + 1 < argc)
+    {
+      output = argv[++i];
+    }
+    else if(arg == "--words" && i + 1 < argc)
+    {
+      max_words = std::atoi(argv[++i]);
+    }
+    else if(arg == "--threads" && i + 1 < argc)
+    {
+      thread_count = std::atoi(argv[++i]);
+    }
+    else if(arg == "--max-length" && i + 1 < argc)
+    {
+      settings.max_length = std::atoi(argv[++i]);
+    }
+    else if(arg == "--no-symbols")
+    {
+      settings.symbols = false;
+    }
+    else
+    {
+      root = arg;
+    }
+  }
+
+  if(root.empty())
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " [-o wordlist.txt] [--words 2000] [--threads n]"
+                 " [--max-length 20] [--no-symbols] source-dir\n";
+    return -1;
+  }
+  thread_count = std::max(1u, thread_count);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::string> files;
+  FindSourceFiles(root, &files);
+
+  // files are handed out one at a time so a few huge files don't leave the
+  // other threads idle, every thread counts into its own table
+  std::atomic<std::size_t> next_file{0};
+  std::atomic<std::size_t> total_bytes{0};
+  std::vector<WordCounts>  counts(thread_count);
+  std::vector<std::thread> threads;
+  for(unsigned int t = 0; t < thread_count; ++t)
+  {
+    threads.emplace_back([&, t]() {
+      std::size_t bytes = 0;
+      for(std::size_t i = next_file++; i < files.size(); i = next_file++)
+      {
+        bytes += TokenizeFile(files[i], settings, &counts[t]);
+      }
+      total_bytes += bytes;
+    });
+  }
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  WordCounts& merged = counts[0];
+  for(unsigned int t = 1; t < thread_count; ++t)
+  {
+    for(const auto& c : counts[t])
+    {
+      merged[c.first] += c.second;
+    }
+    WordCounts().swap(counts[t]);
+  }
+
+  std::vector<RankedWord> ranked;
+  ranked.reserve(merged.size());
+  for(const auto& c : merged)
+  {
+    ranked.push_back(RankedWord{c.first, c.second});
+  }
+  const auto by_count = [](const RankedWord& lhs, const RankedWord& rhs) {
+    return lhs.count != rhs.count ? lhs.count > rhs.count
+                                  : lhs.word < rhs.word;
+  };
+  if(ranked.size() > max_words)
+  {
+    std::partial_sort(
+        ranked.begin(), ranked.begin() + max_words, ranked.end(), by_count);
+    ranked.resize(max_words);
+  }
+  else
+  {
+    std::sort(ranked.begin(), ranked.end(), by_count);
+  }
+
+  std::FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+  if(out == nullptr)
+  {
+    std::cerr << "Failed to open " << output << " for writing\n";
+    return -2;
+  }
+  for(const RankedWord& w : ranked)
+  {
+    std::fprintf(out, "%s %u\n", w.word.c_str(), w.count);
+  }
+  if(out != stdout)
+  {
+    std::fclose(out);
+  }
+
+  const float seconds = std::chrono::duration<float>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  std::cerr << files.size() << " files, " << total_bytes / (1024 * 1024)
+            << " MiB, " << merged.size() << " unique words, kept "
+            << ranked.size() << " in " << seconds << "s on " << thread_count
+            << " threads\n";
+  return 0;
+}
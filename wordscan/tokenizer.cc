@@ -0,0 +1,140 @@
+#include "wordscan/tokenizer.h"
+
+#include <cstring>
+
+namespace
+{
+  bool
+  IsIdentifierStart(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  }
+
+  bool
+  IsIdentifier(char c)
+  {
+    return IsIdentifierStart(c) || (c >= '0' && c <= '9');
+  }
+
+  // longest first so <<= isn't counted as <<
+  const char* const kSymbols[] = {"<<=", ">>=", "...", "->*", "<=>", "::",
+                                  "->",  "++",  "--",  "<<",  ">>",  "<=",
+                                  ">=",  "==",  "!=",  "&&",  "||",  "+=",
+                                  "-=",  "*=",  "/=",  "%=",  "&=",  "|=",
+                                  "^=",  ".*",  "##"};
+
+  // every symbol starts with one of these
+  bool
+  IsSymbolStart(char c)
+  {
+    return std::strchr("<>.-:+=!&|*/%^#", c) != nullptr && c != 0;
+  }
+
+  std::size_t
+  MatchSymbol(const char* p, const char* end)
+  {
+    if(!IsSymbolStart(*p))
+    {
+      return 0;
+    }
+    for(const char* symbol : kSymbols)
+    {
+      const std::size_t length = std::strlen(symbol);
+      if(static_cast<std::size_t>(end - p) >= length &&
+         std::memcmp(p, symbol, length) == 0)
+      {
+        return length;
+      }
+    }
+    return 0;
+  }
+
+  // p points at the opening quote
+  const char*
+  SkipLiteral(const char* p, const char* end)
+  {
+    const char quote = *p;
+    ++p;
+    while(p < end && *p != quote && *p != '\n')
+    {
+      if(*p == '\\')
+      {
+        ++p;
+      }
+      ++p;
+    }
+    return p < end ? p + 1 : end;
+  }
+}
+
+void
+Tokenize(
+    const char*              source,
+    std::size_t              size,
+    const TokenizerSettings& settings,
+    WordCounts*              counts)
+{
+  const char* p   = source;
+  const char* end = source + size;
+  // reused so short words don't allocate per token
+  std::string word;
+
+  while(p < end)
+  {
+    const char c = *p;
+    if(IsIdentifierStart(c))
+    {
+      const char* start = p;
+      while(p < end && IsIdentifier(*p))
+      {
+        ++p;
+      }
+      const std::size_t length = p - start;
+      if(length >= settings.min_length && length <= settings.max_length)
+      {
+        word.assign(start, length);
+        (*counts)[word] += 1;
+      }
+    }
+    else if(c >= '0' && c <= '9')
+    {
+      // numbers including suffixes and hex digits
+      while(p < end && (IsIdentifier(*p) || *p == '.' || *p == '\''))
+      {
+        ++p;
+      }
+    }
+    else if(c == '"' || c == '\'')
+    {
+      p = SkipLiteral(p, end);
+    }
+    else if(c == '/' && p + 1 < end && p[1] == '/')
+    {
+      const void* newline = std::memchr(p, '\n', end - p);
+      p = newline == nullptr ? end : static_cast<const char*>(newline);
+    }
+    else if(c == '/' && p + 1 < end && p[1] == '*')
+    {
+      p += 2;
+      while(p + 1 < end && !(p[0] == '*' && p[1] == '/'))
+      {
+        ++p;
+      }
+      p = p + 1 < end ? p + 2 : end;
+    }
+    else
+    {
+      const std::size_t length = settings.symbols ? MatchSymbol(p, end) : 0;
+      if(length > 0 && length >= settings.min_length)
+      {
+        word.assign(p, length);
+        (*counts)[word] += 1;
+        p += length;
+      }
+      else
+      {
+        ++p;
+      }
+    }
+  }
+}
@@ -0,0 +1,27 @@
+#ifndef WORDSCAN_TOKENIZER_H
+#define WORDSCAN_TOKENIZER_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+typedef std::unordered_map<std::string, unsigned int> WordCounts;
+
+struct TokenizerSettings
+{
+  std::size_t min_length;
+  std::size_t max_length;
+  // count multi character operators like -> and << as words
+  bool symbols;
+};
+
+// Counts the identifiers, keywords and operators in c like source. String
+// and character literals, comments and numbers are skipped.
+void
+Tokenize(
+    const char*              source,
+    std::size_t              size,
+    const TokenizerSettings& settings,
+    WordCounts*              counts);
+
+#endif  // WORDSCAN_TOKENIZER_H